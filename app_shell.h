@@ -0,0 +1,318 @@
+// Armazón de la aplicación, común a la versión secuencial y a la paralela: gen() y los cambios de
+// cantidad con la caché del campo, el bucle y el reporte del modo headless, y con ventana el frame
+// de GLUT (display/draw), el HUD y las teclas comunes. Cada versión aporta una política (app) con
+// su forma de generar, guardar el campo y dibujar; lo que cada plantilla le pide está en su comentario.
+// La parte de GL requiere incluir antes sus cabeceras (no existe con SCREENSAVER_NO_GL).
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "camera.h"
+#include "frame_session.h"
+#include "headless.h"
+#include "particle_cache.h"
+#include "particle_field.h"
+#include "trace.h"
+
+// Parámetros de gen() que vienen de la línea de comandos
+struct FieldOptions {
+    int stars;
+    int iterations;
+    int math_mode;          // 0: sin carga matemática, 1: libm, 2: SIMD (clave de la caché)
+    bool validate;          // --validate-math (genera siempre, sin caché)
+    bool cache;
+    std::string cache_dir;
+};
+
+// Mapea el campo de la caché: las estrellas se copian y app.adopt(map) toma las partículas
+// (las copia y cierra el mapeo, o apunta directo a él)
+template<class App>
+bool loadFieldCache(App &app, const std::string &path, const ParticleCacheKey &key){
+    TRACE_SCOPE("gen: caché");
+    ParticleCacheMap map;
+    if(!particleCacheOpen(path, key, map)) return false;
+    const Particle *cached_stars = (const Particle*)map.stars();
+    app.stars().assign(cached_stars, cached_stars + key.star_count);
+    app.adopt(map);
+    return true;
+}
+
+// Guarda el campo recién generado para las próximas corridas (fuera del tiempo medido);
+// app.cacheField(f, i) da el campo f de la partícula i
+template<class App>
+void saveFieldCache(App &app, const std::string &path, const ParticleCacheKey &key){
+    const float pad[PARTICLE_CACHE_FIELDS] = {0.f, 1.0e9f, 0.f, 0.f, 0.f, 0.f, 0.f};
+    bool ok = particleCacheWrite(path, key, [&](int f, size_t i){ return app.cacheField(f, i); },
+                                 pad, (const float*)app.stars().data());
+    if(ok) std::cout << "   • Campo guardado en caché: " << path << std::endl;
+    else std::cerr << "No se pudo escribir la caché " << path << std::endl;
+}
+
+// gen(): carga el campo de n partículas de la caché o lo genera, y lo valida fuera del tiempo medido.
+//   app.name, app.gen_name          "SECUENCIAL"/"PARALELO" y "SECUENCIAL"/"PARALELA" para los mensajes
+//   app.options()                   FieldOptions de la corrida
+//   app.create(n)                   dimensiona el campo vacío
+//   app.generate(i0, i1, initial)   genera [i0, i1); initial guarda lo necesario para validar
+//   app.generateStars(), app.validate(i0, initial)
+//   app.allocate()                  buffers de render (dentro del tiempo de generación)
+//   app.fieldChanged()              tras generar o cambiar la cantidad (recorte, índice)
+//   app.fingerprint(), app.reportField()   huella y líneas propias del resumen
+template<class App>
+void generateField(App &app, FrameSession &session, int n){
+    const FieldOptions opt = app.options();
+    TRACE_SCOPE("gen");
+    auto gen_start = std::chrono::high_resolution_clock::now();
+
+    std::cout << "Generando " << n << " partículas " << app.name << std::endl;
+
+    // Campo en caché: se mapea sin recalcular (la validación necesita generar, así que no la usa)
+    ParticleCacheKey cache_key = particleCacheKey(n, opt.stars, opt.iterations, opt.math_mode);
+    std::string cache_path = opt.cache ? particleCachePath(opt.cache_dir, cache_key) : "";
+    bool cached = !cache_path.empty() && !opt.validate && loadFieldCache(app, cache_path, cache_key);
+
+    typename App::Initial initial;
+    if(!cached){
+        app.create(n);
+        app.generate(0, n, initial);
+        app.generateStars();
+    }
+    app.allocate();
+
+    double gen_time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - gen_start).count();
+    if(session.timing_enabled) session.total_gen_time += gen_time;
+
+    if(cached) std::cout << "Campo cargado de caché (mmap) en " << gen_time << " segundos: " << cache_path << std::endl;
+    else std::cout << "Generación " << app.gen_name << " completada en " << gen_time << " segundos" << std::endl;
+    if(!cached && !cache_path.empty()) saveFieldCache(app, cache_path, cache_key);
+
+    // Validación fuera del tiempo medido: cada partícula se recalcula con libm
+    app.validate(0, initial);
+    app.fieldChanged();
+    std::cout << "   • Partículas: " << n << " con " << opt.iterations << " iteraciones cada una" << std::endl;
+    std::cout << "   • Estrellas: " << opt.stars << std::endl;
+    printf("   • Huella de datos: %016llx\n", (unsigned long long)app.fingerprint());
+    app.reportField();
+    std::cout << "   • Operaciones matemáticas: ~" << (n * opt.iterations * 10) << " por frame" << std::endl;
+    std::cout << std::endl;
+}
+
+// Cambia la cantidad de partículas en caliente (teclas [ ] y --ramp): al crecer se generan solo
+// las nuevas y se agregan al final; al reducir se descartan las últimas. Como cada partícula
+// depende de su índice, el resultado es idéntico a gen(n).
+//   app.size(), app.resize(n)       cantidad actual y cambio del campo (la reserva es de la versión)
+//   app.beginResize()               antes de tocar el campo
+//   app.resizeNote(out)             detalle del mensaje (capacidad, buffers)
+//   app.resized(old_n, n)           después de validar (autoajuste, atributos del shader)
+// y generate/validate/fieldChanged como en generateField
+template<class App>
+void resizeField(App &app, FrameSession &session, int &particle_count, int n){
+    n = std::max(PARTICLE_MIN, std::min(PARTICLE_MAX, n));
+    const int old_n = app.size();
+    if(n == old_n) return;
+
+    TRACE_SCOPE("gen: cambio de partículas");
+    app.beginResize();
+    auto gen_start = std::chrono::high_resolution_clock::now();
+
+    app.resize(n);
+    typename App::Initial initial;
+    if(n > old_n) app.generate(old_n, n, initial);
+    particle_count = n;
+    app.fieldChanged();
+
+    double gen_time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - gen_start).count();
+    if(session.timing_enabled) session.total_gen_time += gen_time;
+
+    std::cout << "Partículas: " << old_n << " -> " << n << " (" << (n > old_n ? "generadas " : "descartadas ")
+              << std::abs(n - old_n) << " en " << gen_time << " s";
+    app.resizeNote(std::cout);
+    std::cout << ")" << std::endl;
+    app.validate(old_n, initial);
+    app.resized(old_n, n);
+}
+
+// Bucle del modo headless: calentamiento, tiempo y latencias por etapa de cada frame y rampa.
+//   app.resetFrameTimers()          al terminar el calentamiento
+//   app.stageTotals()               acumulados por etapa (std::array, ver FrameSession::recordLatency)
+//   app.headlessFrame(f)            fija T y dibuja el frame f; devuelve el swap/glFinish (0 sin GL)
+//   app.extraLatency()              etapa opcional del frame (negativo: sin muestra)
+//   app.count(), app.step(), app.resizeParticles(n)   escalones de --ramp (como las teclas [ ])
+template<class App>
+void runHeadlessFrames(App &app, FrameSession &session, const HeadlessConfig &cfg, HeadlessFrames &frames){
+    for(int f = 0; f < cfg.warmup + cfg.frames; f++){
+        if(f == cfg.warmup) app.resetFrameTimers();
+        TRACE_SCOPE("frame");
+        auto stages_before = app.stageTotals();
+        session.frame_start = FrameSession::Clock::now();
+
+        double swap_time = app.headlessFrame(f);
+
+        double frame_time = session.endFrame();
+        if(!cfg.gl) session.total_draw_time += frame_time;
+        session.recordLatency(frame_time, stages_before, app.stageTotals(), swap_time, app.extraLatency());
+
+        // Rampa de carga: al cerrar cada escalón se agregan partículas (fuera del frame)
+        frames.record(f, frame_time, app.count(), [&]{
+            if(app.count() < PARTICLE_MAX) app.resizeParticles(app.count() + app.step());
+        });
+    }
+    frames.finish(app.count());
+}
+
+// Reporte del modo headless. app.reportStages(frames) escribe las etapas propias, app.reportExtra()
+// lo que va tras el frame completo y checksum() muestra y devuelve el checksum del framebuffer
+// usado; al final va la línea BENCH del barrido.
+//   app.name, app.bench_name, app.threads(), app.count(), app.iterations(), app.fingerprint()
+template<class App, class Checksum>
+void reportHeadless(App &app, const FrameSession &session, const HeadlessConfig &cfg,
+                    const HeadlessFrames &frames, Checksum &&checksum){
+    const int n = session.frame_count_timing;
+    std::cout << std::endl << "=== RESULTADOS HEADLESS (" << app.name << ") ===" << std::endl;
+    std::cout << "Frames: " << n << " (+" << cfg.warmup << " de calentamiento) | Hilos: " << app.threads()
+              << " | Partículas: " << app.count() << std::endl;
+    std::cout << "Generación: " << session.total_gen_time << " segundos" << std::endl;
+    app.reportStages(n);
+    printHeadlessStage("Frame completo", session.total_computation_time, n);
+    app.reportExtra();
+    frames.printPercentiles();
+    std::cout << "FPS (simulación): " << n / session.total_computation_time << std::endl;
+    double sum = checksum();
+    std::cout << "======================================" << std::endl;
+    printBenchLine(app.bench_name, app.count(), app.iterations(), app.threads(), frames.seconds, sum, app.fingerprint());
+}
+
+#ifndef SCREENSAVER_NO_GL
+// Texto del HUD: líneas desde arriba a la izquierda con la fuente de GLUT sobre una proyección
+// ortográfica de la ventana (la de la escena se restaura al destruirse)
+struct HudText {
+    int y;
+
+    HudText(int w, int h) : y(h - 25) {
+        glMatrixMode(GL_PROJECTION);
+        glPushMatrix();
+        glLoadIdentity();
+        glOrtho(0, w, 0, h, -1, 1);
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+        glLoadIdentity();
+
+        glDisable(GL_DEPTH_TEST);
+        glColor3f(0.0f, 1.0f, 0.0f);
+    }
+
+    ~HudText(){
+        glEnable(GL_DEPTH_TEST);
+        glPopMatrix();
+        glMatrixMode(GL_PROJECTION);
+        glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+    }
+
+    void line(const char *text){
+        glRasterPos2f(10, y);
+        for(const char *c = text; *c; c++) glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, *c);
+        y -= 20;
+    }
+
+    template<class... Args>
+    void print(const char *format, Args... args){
+        char text[400];
+        snprintf(text, sizeof(text), format, args...);
+        line(text);
+    }
+};
+
+// HUD (tecla F): contadores de la versión (top), percentiles del frame en la última ventana de
+// ~1 s, etapas de la versión (stages) y la ayuda de la cámara libre
+template<class Top, class Stages>
+void drawHud(FrameSession &session, const Camera &camera, int w, int h, Top &&top, Stages &&stages){
+    if(!session.showFPS) return;
+    session.tickFPS();
+    HudText hud(w, h);
+    top(hud);
+
+    // Percentiles de la última ventana de ~1 s: el ritmo de frames, no solo el promedio
+    const LatencyHistogram &fh = session.latency_hud.hist[0];
+    hud.print("Frame ms  p50: %.2f | p95: %.2f | p99: %.2f | max: %.2f",
+              fh.percentileMs(50), fh.percentileMs(95), fh.percentileMs(99), fh.maxMs());
+    stages(hud);
+    if(camera.freeMode) hud.line("WASD: Movimiento | QE: Arriba/Abajo | Mouse: Mirar");
+}
+
+// draw(): cámara, escena (app.renderScene()) y HUD (app.drawHud()), con el tiempo de dibujo
+template<class App>
+void drawFrame(App &app, FrameSession &session, const Camera &camera, float t){
+    auto draw_start = FrameSession::Clock::now();
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE,GL_ONE);
+    glDisable(GL_LIGHTING);
+    camera.apply(t);
+
+    app.renderScene();
+
+    glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
+    app.drawHud();
+
+    if(session.timing_enabled){
+        session.total_draw_time += std::chrono::duration<double>(FrameSession::Clock::now() - draw_start).count();
+    }
+}
+
+// display() de GLUT: mide el frame, dibuja (app.draw()) y registra las latencias por etapa.
+//   app.beginFrame(f)               fija T para el frame f de la ventana
+//   app.progress(out)               agrega lo propio al mensaje periódico de consola
+// y stageTotals/extraLatency como en runHeadlessFrames
+template<class App>
+void displayFrame(App &app, FrameSession &session){
+    auto stages_before = app.stageTotals();
+    if(session.timing_enabled) session.frame_start = FrameSession::Clock::now();
+
+    TRACE_SCOPE("frame");
+    static int display_frame = 0;
+    app.beginFrame(display_frame++);
+    glClearColor(0.02f,0.02f,0.06f,1.f);
+    glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
+    glLoadIdentity();
+    app.draw();
+    auto swap_start = FrameSession::Clock::now();
+    {
+        TRACE_SCOPE("swap");
+        glutSwapBuffers();
+    }
+
+    if(session.timing_enabled){
+        double frame_time = session.endFrame();
+        double swap_time = std::chrono::duration<double>(session.frame_end - swap_start).count();
+        session.recordLatency(frame_time, stages_before, app.stageTotals(), swap_time, app.extraLatency());
+        session.printProgress([&](std::ostream &out){ app.progress(out); });
+    }
+}
+
+// Teclas comunes: ESC (app.quit(): guarda métricas y sale), cámara, F (HUD) y [ ] (cantidad de
+// partículas de a app.step(), con app.resizeParticles(n)). Devuelve false si la tecla es de la versión.
+template<class App>
+bool shellKey(App &app, FrameSession &session, Camera &camera, unsigned char k){
+    if(camera.key(k)) return true;
+    switch(k){
+        case 27: // ESC
+            app.quit();
+            exit(0);
+        case 'f': case 'F':
+            session.showFPS = !session.showFPS;
+            return true;
+        case ']':
+            app.resizeParticles(app.count() + app.step());
+            return true;
+        case '[':
+            app.resizeParticles(app.count() - app.step());
+            return true;
+    }
+    return false;
+}
+#endif
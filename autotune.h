@@ -0,0 +1,101 @@
+// Autoajuste en línea de las regiones paralelas del frame (--autotune). Cada etapa (estrellas, pases
+// fusionados o cada pase por separado) tiene su StageTuner, que prueba configuraciones durante unos
+// frames cada una y se queda con la más rápida (mediana de sus muestras). La búsqueda es por
+// coordenadas: primero la cantidad de hilos con el reparto estático por hilo y luego, con esos
+// hilos, el schedule (static/dynamic/guided) y el tamaño de chunk. Las regiones usan
+// schedule(runtime) y fijan la configuración con omp_set_schedule antes de entrar.
+#pragma once
+
+#include <omp.h>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+// Configuración de una región paralela. chunk está en unidades de trabajo de la etapa
+// (estrellas, bloques SIMD o partículas); 0 es un tramo contiguo por hilo (el static por defecto).
+struct StageConfig {
+    int threads = 1;
+    omp_sched_t kind = omp_sched_static;
+    int chunk = 0;
+
+    bool operator==(const StageConfig &o) const { return threads == o.threads && kind == o.kind && chunk == o.chunk; }
+};
+
+inline const char *scheduleName(omp_sched_t kind){
+    switch(kind){
+        case omp_sched_dynamic: return "dynamic";
+        case omp_sched_guided: return "guided";
+        default: return "static";
+    }
+}
+
+class StageTuner {
+public:
+    static const int SAMPLES = 5;   // frames medidos por configuración
+
+    // chunk_sizes: tamaños a probar en la segunda fase
+    void init(const char *stage, int max_threads, std::vector<int> chunk_sizes){
+        name = stage;
+        thread_limit = std::max(1, max_threads);
+        chunks = std::move(chunk_sizes);
+        restart();
+    }
+
+    // Vuelve a la primera fase (al cambiar la carga, p. ej. la cantidad de partículas)
+    void restart(){
+        phase = 0;
+        index = 0;
+        samples.clear();
+        best_time = 1e30;
+        candidates.clear();
+        for(int t = 1; t < thread_limit; t *= 2) candidates.push_back({t, omp_sched_static, 0});
+        candidates.push_back({thread_limit, omp_sched_static, 0});
+    }
+
+    const StageConfig &current() const { return phase < 2 ? candidates[index] : best; }
+    bool settled() const { return phase == 2; }
+
+    // Tiempo de la etapa con la configuración cfg; las muestras de otra configuración (frames
+    // calculados antes de cambiar de candidata, p. ej. con el pipeline) se descartan
+    void record(const StageConfig &cfg, double seconds){
+        if(settled() || !(cfg == current())) return;
+        samples.push_back(seconds);
+        if((int)samples.size() < SAMPLES) return;
+
+        std::nth_element(samples.begin(), samples.begin() + SAMPLES / 2, samples.end());
+        double median = samples[SAMPLES / 2];
+        samples.clear();
+        if(median < best_time){
+            best = candidates[index];
+            best_time = median;
+        }
+        if(++index < (int)candidates.size()) return;
+
+        index = 0;
+        if(phase == 0 && best.threads > 1){
+            printf("Autoajuste [%s]: %d hilos (%.3f ms); probando schedules\n", name, best.threads, best_time * 1000.0);
+            phase = 1;
+            candidates.clear();
+            for(omp_sched_t kind : {omp_sched_static, omp_sched_dynamic, omp_sched_guided}){
+                for(int c : chunks) candidates.push_back({best.threads, kind, c});
+            }
+            return;
+        }
+        phase = 2;
+        printf("Autoajuste [%s]: fijado en %d hilos, schedule %s", name, best.threads, scheduleName(best.kind));
+        if(best.chunk > 0) printf(" chunk %d", best.chunk);
+        else printf(" por hilo");
+        printf(" (%.3f ms)\n", best_time * 1000.0);
+    }
+
+private:
+    const char *name = "";
+    int thread_limit = 1;
+    std::vector<int> chunks;
+    std::vector<StageConfig> candidates;
+    std::vector<double> samples;
+    int phase = 0;                  // 0: hilos, 1: schedule y chunk, 2: fijado
+    int index = 0;
+    StageConfig best;
+    double best_time = 1e30;
+};
@@ -0,0 +1,94 @@
+// Cámara y entrada de usuario, comunes a la versión secuencial y a la paralela: cámara orbital
+// por defecto o libre (WASD/QE + mouse), con la proyección y la vista en GL.
+// Las funciones de GL/GLUT requieren incluir antes sus cabeceras (no existen con SCREENSAVER_NO_GL).
+#pragma once
+
+#include <cmath>
+
+// Cámara en modo “orbital” o “libre” (freeMode), con el estado del mouse para mirar
+struct Camera {
+    float x = 30.0f, y = 5.0f, z = 0.0f;
+    float pitch = 0.0f, yaw = 0.0f;
+    float speed = 2.0f;
+    bool freeMode = false;
+    int lastMouseX = 0, lastMouseY = 0;
+    bool mousePressed = false;
+
+    // Teclas de la cámara (C, WASD, QE); devuelve false si la tecla no es de la cámara
+    bool key(unsigned char k){
+        const float rad = yaw * M_PI / 180.0f;
+        switch(k){
+            case 'c': case 'C':
+                freeMode = !freeMode;
+                if(!freeMode){
+                    x = 30.0f; y = 5.0f; z = 0.0f;
+                    pitch = 0.0f; yaw = 0.0f;
+                }
+                return true;
+            case 'w': case 'W':
+                if(freeMode){ x += speed * sinf(rad); z -= speed * cosf(rad); }
+                return true;
+            case 's': case 'S':
+                if(freeMode){ x -= speed * sinf(rad); z += speed * cosf(rad); }
+                return true;
+            case 'a': case 'A':
+                if(freeMode){ x -= speed * cosf(rad); z -= speed * sinf(rad); }
+                return true;
+            case 'd': case 'D':
+                if(freeMode){ x += speed * cosf(rad); z += speed * sinf(rad); }
+                return true;
+            case 'q': case 'Q':
+                if(freeMode) y += speed;
+                return true;
+            case 'e': case 'E':
+                if(freeMode) y -= speed;
+                return true;
+        }
+        return false;
+    }
+
+    // Botón izquierdo del mouse presionado o soltado en (mx, my)
+    void press(bool down, int mx, int my){
+        mousePressed = down;
+        lastMouseX = mx;
+        lastMouseY = my;
+    }
+
+    // Arrastre a (mx, my): en modo libre gira la vista (pitch limitado a ±89°)
+    void drag(int mx, int my){
+        if(!freeMode || !mousePressed) return;
+        yaw += (mx - lastMouseX) * 0.2f;
+        pitch += (my - lastMouseY) * 0.2f;
+        if(pitch > 89.0f) pitch = 89.0f;
+        if(pitch < -89.0f) pitch = -89.0f;
+        lastMouseX = mx;
+        lastMouseY = my;
+    }
+
+#ifndef SCREENSAVER_NO_GL
+    // Vista en el instante t: órbita alrededor del túnel o cámara libre
+    void apply(float t) const {
+        if(!freeMode){
+            float r=28.f+7.f*sinf(0.32f*t);
+            float a=0.3f*t;
+            float h=3.8f+2.8f*sinf(0.21f*t+0.9f);
+            gluLookAt(r*cosf(a),h,r*sinf(a),0,0,-260,0,1,0);
+        } else {
+            glLoadIdentity();
+            glRotatef(pitch, 1.0f, 0.0f, 0.0f);
+            glRotatef(yaw, 0.0f, 1.0f, 0.0f);
+            glTranslatef(-x, -y, -z);
+        }
+    }
+#endif
+};
+
+#ifndef SCREENSAVER_NO_GL
+// Proyección de la ventana de w x h (la misma que reproduce headless_fb en CPU)
+inline void cameraProjection(int w, int h){
+    glViewport(0,0,w,h);
+    glMatrixMode(GL_PROJECTION); glLoadIdentity();
+    gluPerspective(72.0,(double)w/(double)h,0.1,6000.0);
+    glMatrixMode(GL_MODELVIEW);
+}
+#endif
@@ -0,0 +1,79 @@
+// Generador aleatorio basado en contador (Philox4x32-10, Salmon et al. 2011): cada número es una
+// función pura de (semilla, índice de partícula, sorteo), sin estado compartido entre hilos.
+// Así gen() produce exactamente los mismos datos con cualquier num_threads y schedule, y la
+// versión secuencial y la paralela generan el mismo campo de partículas.
+// Solo usa multiplicaciones 32x32->64, sumas y xor: sin ramas ni tablas, vectorizable por el compilador.
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// Semillas de cada campo (las mismas que usaban los mt19937 originales)
+const uint32_t RNG_SEED_PARTICLES = 1337;
+const uint32_t RNG_SEED_STARS = 2674;
+
+struct Philox4x32 {
+    uint32_t v[4];
+};
+
+// 10 rondas de Philox4x32 sobre el contador (c0, c1, c2, c3) con clave (k0, k1)
+inline Philox4x32 philox4x32(uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3, uint32_t k0, uint32_t k1){
+    const uint32_t M0 = 0xD2511F53u, M1 = 0xCD9E8D57u;
+    const uint32_t W0 = 0x9E3779B9u, W1 = 0xBB67AE85u;
+    for(int round = 0; round < 10; round++){
+        uint64_t p0 = (uint64_t)M0 * c0;
+        uint64_t p1 = (uint64_t)M1 * c2;
+        uint32_t hi0 = (uint32_t)(p0 >> 32), lo0 = (uint32_t)p0;
+        uint32_t hi1 = (uint32_t)(p1 >> 32), lo1 = (uint32_t)p1;
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
+        k0 += W0;
+        k1 += W1;
+    }
+    return {{c0, c1, c2, c3}};
+}
+
+// Uniforme en [0, 1) con los 24 bits altos (todos los floats resultantes son exactos)
+inline float rngUniform(uint32_t x){
+    return (float)(x >> 8) * (1.0f / 16777216.0f);
+}
+
+// Uniforme en [-1, 1)
+inline float rngSigned(uint32_t x){
+    return 2.0f * rngUniform(x) - 1.0f;
+}
+
+// Flujo de números de un elemento: el sorteo k usa el bloque k/4 del contador (index, k/4, 0, 0)
+struct CounterRng {
+    uint32_t seed, index;
+    uint32_t block = 0, next = 4;
+    Philox4x32 out = {};
+
+    CounterRng(uint32_t s, uint32_t i) : seed(s), index(i) {}
+
+    uint32_t bits(){
+        if(next == 4){
+            out = philox4x32(index, block++, 0, 0, seed, 0);
+            next = 0;
+        }
+        return out.v[next++];
+    }
+
+    float U(){ return rngUniform(bits()); }
+    float S(){ return rngSigned(bits()); }
+};
+
+// Huella FNV-1a de los datos generados (sobre los bits de cada float), para comparar ejecuciones
+inline uint64_t fingerprintMix(uint64_t h, float v){
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    for(int b = 0; b < 4; b++){
+        h ^= (bits >> (8 * b)) & 0xFF;
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+const uint64_t FINGERPRINT_BASIS = 0xCBF29CE484222325ull;
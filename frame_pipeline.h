@@ -0,0 +1,99 @@
+// Pipeline de frames (--pipeline N): un hilo productor calcula los frames siguientes en N juegos de
+// buffers mientras el hilo de GL envía el actual. El envío deja de esperar al cálculo a cambio de
+// mostrar cada frame uno o más frames después de calculado (por eso se calcula para un T predicho).
+//
+// Cada juego circula así: el hilo principal escribe sus parámetros y lo pide (request), el productor
+// lo llena y lo deja listo, el principal lo toma (acquire) en el orden en que lo pidió, lo envía y
+// vuelve a pedirlo. El productor solo toca juegos pedidos y el principal solo los tomados.
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+template<class Slot>
+class FramePipeline {
+public:
+    ~FramePipeline(){ stop(); }
+
+    bool running() const { return worker.joinable(); }
+    int depth() const { return (int)slots.size(); }
+    Slot &slot(int i){ return slots[i]; }
+
+    // Crea `depth` juegos vacíos y lanza el productor; compute(slot) llena un juego
+    void start(int depth, std::function<void(Slot&)> fn){
+        reset();
+        slots.assign(depth, Slot());
+        compute = std::move(fn);
+        quit = false;
+        worker = std::thread(&FramePipeline::produce, this);
+    }
+
+    // Espera a que el productor termine el juego en curso y descarta los pedidos pendientes;
+    // los juegos siguen disponibles hasta reset()
+    void stop(){
+        if(!worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        cv.notify_all();
+        worker.join();
+        requested.clear();
+        ready.clear();
+    }
+
+    void reset(){
+        stop();
+        slots.clear();
+    }
+
+    // El juego i, con sus parámetros ya escritos, pasa a la cola de cálculo
+    void request(int i){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            requested.push_back(i);
+        }
+        cv.notify_all();
+    }
+
+    // Siguiente juego terminado, en el orden de los pedidos (espera si aún se está calculando)
+    int acquire(){
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]{ return !ready.empty(); });
+        int i = ready.front();
+        ready.pop_front();
+        return i;
+    }
+
+private:
+    std::vector<Slot> slots;
+    std::function<void(Slot&)> compute;
+    std::deque<int> requested, ready;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread worker;
+    bool quit = false;
+
+    void produce(){
+        while(true){
+            int i;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&]{ return quit || !requested.empty(); });
+                if(quit) return;
+                i = requested.front();
+                requested.pop_front();
+            }
+            compute(slots[i]);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ready.push_back(i);
+            }
+            cv.notify_all();
+        }
+    }
+};
@@ -0,0 +1,151 @@
+// Medición de la sesión, común a la versión secuencial y a la paralela: tiempos acumulados de
+// generación, dibujo y frame, histogramas de latencia por etapa (sesión, ventana en curso y
+// última ventana de ~1 s para el HUD), contador de FPS y el archivo de métricas al salir.
+// Cada versión define sus etapas; la etapa 0 es siempre el frame completo.
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include "latency.h"
+
+// Tiempo relativo desde que inició el programa
+inline float now(){
+    static auto t0=std::chrono::high_resolution_clock::now();
+    auto t=std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<float>(t-t0).count();
+}
+
+// Textos propios de cada versión en el archivo de métricas y en el resumen de consola
+struct MetricsLabels {
+    const char *path;       // archivo (se agrega al final)
+    const char *title;      // título del bloque en el archivo
+    const char *summary;    // título del resumen en consola
+};
+
+struct FrameSession {
+    using Clock = std::chrono::high_resolution_clock;
+
+    Clock::time_point start_time;
+    Clock::time_point frame_start;
+    Clock::time_point frame_end;
+    double total_gen_time = 0.0;            // tiempo total de generación por sesión
+    double total_draw_time = 0.0;           // tiempo total de dibujo por sesión
+    double total_computation_time = 0.0;    // tiempo acumulado por frame (display)
+    int frame_count_timing = 0;             // #frames medidos
+    bool timing_enabled = true;             // habilita/inhabilita medición
+
+    // Histogramas de latencia: toda la sesión (se vuelcan al salir), la ventana en curso y la
+    // última ventana completa de ~1 s (la que muestra el HUD)
+    LatencyStages latency_session;
+    LatencyStages latency_window;
+    LatencyStages latency_hud;
+    float latency_window_start = 0.0f;
+
+    // HUD: FPS de la última ventana de ~1 s (tecla F lo oculta)
+    bool showFPS = true;
+    int frameCount = 0;
+    float lastTime = 0.0f;
+    float currentFPS = 0.0f;
+
+    explicit FrameSession(std::initializer_list<const char*> stages)
+        : latency_session(stages), latency_window(stages), latency_hud(stages) {}
+
+    // Reinicia los acumuladores por frame (al terminar el calentamiento del modo headless)
+    void resetFrames(){
+        total_draw_time = total_computation_time = 0.0;
+        frame_count_timing = 0;
+        latency_session.reset();
+    }
+
+    // Cierra el frame que empezó en frame_start: lo acumula y devuelve su duración en segundos
+    double endFrame(){
+        frame_end = Clock::now();
+        double frame_time = std::chrono::duration<double>(frame_end - frame_start).count();
+        total_computation_time += frame_time;
+        frame_count_timing++;
+        return frame_time;
+    }
+
+    // Registra la latencia del frame: etapa 0 el frame, 1..N la diferencia de los acumulados por
+    // etapa (before/after), N+1 el swap y N+2 una etapa opcional (negativa: sin muestra)
+    template<size_t N>
+    void recordLatency(double frame_seconds, const std::array<double, N> &before, const std::array<double, N> &after,
+                       double swap_seconds, double extra_seconds = -1.0){
+        for(LatencyStages *l : {&latency_session, &latency_window}){
+            l->record(0, frame_seconds);
+            for(size_t s = 0; s < N; s++) l->record(1 + (int)s, after[s] - before[s]);
+            l->record(N + 1, swap_seconds);
+            if(extra_seconds >= 0.0) l->record(N + 2, extra_seconds);
+        }
+        float t = now();
+        if(t - latency_window_start >= 1.0f){
+            latency_hud = latency_window;
+            latency_window.reset();
+            latency_window_start = t;
+        }
+    }
+
+    // Cuenta un frame dibujado con el HUD y actualiza currentFPS una vez por segundo
+    void tickFPS(){
+        frameCount++;
+        float currentTime = now();
+        if(currentTime - lastTime >= 1.0f){
+            currentFPS = frameCount / (currentTime - lastTime);
+            frameCount = 0;
+            lastTime = currentTime;
+        }
+    }
+
+    // Mensaje periódico para seguimiento en consola (cada 1000 frames); extra(out) agrega lo propio
+    template<class Extra>
+    void printProgress(Extra &&extra) const {
+        if(frame_count_timing % 1000 != 0) return;
+        std::cout << "Frames procesados: " << frame_count_timing <<
+                ", Tiempo promedio por frame: " <<
+                (total_computation_time / frame_count_timing) * 1000 << " ms" <<
+                ", FPS actual: " << currentFPS;
+        extra(std::cout);
+        std::cout << std::endl;
+    }
+
+    // Guarda las métricas de la sesión en el archivo y muestra el resumen. header(out) escribe las
+    // líneas propias de la versión tras el título (archivo y consola); timing(out), las del
+    // archivo tras el tiempo de renderizado.
+    template<class Header, class Timing>
+    void saveMetrics(const MetricsLabels &labels, int particles, int iterations, int stars,
+                     Header &&header, Timing &&timing) const {
+        if(frame_count_timing <= 0) return;
+        std::ofstream file(labels.path, std::ios::app);
+        file << labels.title << std::endl;
+        header(file);
+        file << "Partículas procesadas: " << particles << std::endl;
+        file << "Iteraciones matemáticas por partícula: " << iterations << std::endl;
+        file << "Estrellas: " << stars << std::endl;
+        file << "Frames procesados: " << frame_count_timing << std::endl;
+        file << "Tiempo de generación por frame: " << (total_gen_time / frame_count_timing) * 1000 << " ms" << std::endl;
+        file << "Tiempo de renderizado por frame: " << (total_draw_time / frame_count_timing) * 1000 << " ms" << std::endl;
+        timing(file);
+        file << "Tiempo total de computación: " << total_computation_time << " segundos" << std::endl;
+        file << "Tiempo por frame: " << (total_computation_time / frame_count_timing) * 1000 << " ms" << std::endl;
+        file << "FPS basado en cálculos: " << frame_count_timing / total_computation_time << std::endl;
+        file << "Operaciones matemáticas estimadas por frame: " << (particles * iterations * 10) << std::endl;
+        file << "Latencia por frame y etapa (histograma):" << std::endl;
+        latency_session.writeReport(file);
+        file << "=====================================" << std::endl << std::endl;
+        file.close();
+
+        // Resumen en consola
+        std::cout << "\n" << labels.summary << std::endl;
+        header(std::cout);
+        std::cout << "Partículas: " << particles << " | Iteraciones: " << iterations << std::endl;
+        std::cout << "Frames procesados: " << frame_count_timing << std::endl;
+        std::cout << "Tiempo total de computación: " << total_computation_time << " segundos" << std::endl;
+        std::cout << "Tiempo por frame: " << (total_computation_time / frame_count_timing) * 1000 << " ms" << std::endl;
+        std::cout << "FPS: " << frame_count_timing / total_computation_time << std::endl;
+        latency_session.writeReport(std::cout);
+        std::cout << "=====================================" << std::endl;
+    }
+};
@@ -0,0 +1,57 @@
+// Volumen de visión de la cámara como 6 planos (extraídos de proyección*vista, Gribb-Hartmann) y
+// pruebas para geometría que gira alrededor del eje z: un anillo de radio R centrado en el eje a
+// una profundidad z, o un cilindro entre dos profundidades. El túnel de partículas se recorta con
+// estas pruebas sin conocer el ángulo de cada partícula (que depende del pase y del instante).
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include "simd.h"
+
+enum CullClass : uint8_t { CULL_OUT, CULL_PARTIAL, CULL_IN };
+
+struct ViewFrustum {
+    float plane[6][4];      // a x + b y + c z + d >= 0 dentro del volumen
+    float reach[6];         // |(a, b)|: cuánto acerca o aleja al plano un anillo de radio 1
+
+    // mvp en orden de columnas (como OpenGL). guard >= 1 agranda el volumen en NDC (|x|,|y|,|z| <= guard*w)
+    // para no descartar puntos grandes con el centro apenas fuera de pantalla ni perder otros por redondeo.
+    void fromMatrix(const float *mvp, float guard){
+        const int sign[6] = {1, -1, 1, -1, 1, -1};
+        const int row[6] = {0, 0, 1, 1, 2, 2};
+        for(int p = 0; p < 6; p++){
+            for(int c = 0; c < 4; c++){
+                plane[p][c] = guard * mvp[c*4 + 3] + sign[p] * mvp[c*4 + row[p]];
+            }
+            reach[p] = sqrtf(plane[p][0]*plane[p][0] + plane[p][1]*plane[p][1]);
+        }
+    }
+
+    // Algún punto del anillo (radio R, profundidad z) puede quedar dentro
+    bool ringVisible(float z, float R) const {
+        for(int p = 0; p < 6; p++){
+            if(plane[p][2]*z + plane[p][3] + R*reach[p] < 0.f) return false;
+        }
+        return true;
+    }
+
+    vfloat ringVisible(vfloat z, vfloat R) const {
+        vfloat inside = vge(vfloat(plane[0][2])*z + vfloat(plane[0][3]) + R*vfloat(reach[0]), vfloat(0.f));
+        for(int p = 1; p < 6; p++){
+            inside = inside & vge(vfloat(plane[p][2])*z + vfloat(plane[p][3]) + R*vfloat(reach[p]), vfloat(0.f));
+        }
+        return inside;
+    }
+
+    // Cilindro de radio R entre z0 y z1: fuera si un plano lo deja entero del lado de afuera,
+    // dentro si todos lo dejan entero del lado de adentro (cada plano es lineal en z)
+    CullClass classifyCylinder(float z0, float z1, float R) const {
+        bool all_inside = true;
+        for(int p = 0; p < 6; p++){
+            float d0 = plane[p][2]*z0 + plane[p][3], d1 = plane[p][2]*z1 + plane[p][3];
+            if(fmaxf(d0, d1) + R*reach[p] < 0.f) return CULL_OUT;
+            if(fminf(d0, d1) - R*reach[p] < 0.f) all_inside = false;
+        }
+        return all_inside ? CULL_IN : CULL_PARTIAL;
+    }
+};
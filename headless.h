@@ -0,0 +1,214 @@
+// Modo headless: framebuffer en CPU y cámara calculada sin GL/GLUT.
+// Permite medir el pipeline de simulación sin ventana, vsync ni compositor.
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+
+// Parámetros del modo headless (se configuran con --headless --frames N)
+struct HeadlessConfig {
+    bool enabled = false;
+    int frames = 300;              // Frames a simular antes de salir
+    float dt = 1.0f / 60.0f;       // Paso de tiempo fijo: T = frame * dt (reproducible)
+    bool gl = false;               // --gl: dibuja con GL real en un contexto sin ventana (headless_gl.h)
+    int warmup = 0;                // --warmup N: frames previos que no entran en las estadísticas
+    bool save_metrics = true;      // --no-save: no agrega el resumen al archivo *_timing_results.txt
+    int ramp = 0;                  // --ramp N: cada N frames medidos agrega --particle-step partículas
+};
+
+// Multiplicación de matrices 4x4 en orden de columnas (igual que OpenGL): out = a * b
+inline void mat4Mul(const float *a, const float *b, float *out){
+    float tmp[16];
+    for(int c = 0; c < 4; c++){
+        for(int r = 0; r < 4; r++){
+            tmp[c*4 + r] = a[0*4 + r]*b[c*4 + 0] + a[1*4 + r]*b[c*4 + 1]
+                         + a[2*4 + r]*b[c*4 + 2] + a[3*4 + r]*b[c*4 + 3];
+        }
+    }
+    for(int i = 0; i < 16; i++) out[i] = tmp[i];
+}
+
+// Equivalente a gluPerspective
+inline void mat4Perspective(float fovy_deg, float aspect, float znear, float zfar, float *m){
+    float f = 1.0f / tanf(fovy_deg * 3.14159265f / 360.0f);
+    for(int i = 0; i < 16; i++) m[i] = 0.0f;
+    m[0] = f / aspect;
+    m[5] = f;
+    m[10] = (zfar + znear) / (znear - zfar);
+    m[11] = -1.0f;
+    m[14] = 2.0f * zfar * znear / (znear - zfar);
+}
+
+// Equivalente a gluLookAt
+inline void mat4LookAt(float ex, float ey, float ez, float cx, float cy, float cz,
+                       float ux, float uy, float uz, float *m){
+    float fx = cx - ex, fy = cy - ey, fz = cz - ez;
+    float fl = sqrtf(fx*fx + fy*fy + fz*fz);
+    fx /= fl; fy /= fl; fz /= fl;
+    // s = f x up
+    float sx = fy*uz - fz*uy, sy = fz*ux - fx*uz, sz = fx*uy - fy*ux;
+    float sl = sqrtf(sx*sx + sy*sy + sz*sz);
+    sx /= sl; sy /= sl; sz /= sl;
+    // u = s x f
+    float vx = sy*fz - sz*fy, vy = sz*fx - sx*fz, vz = sx*fy - sy*fx;
+    m[0] = sx;  m[4] = sy;  m[8]  = sz;  m[12] = -(sx*ex + sy*ey + sz*ez);
+    m[1] = vx;  m[5] = vy;  m[9]  = vz;  m[13] = -(vx*ex + vy*ey + vz*ez);
+    m[2] = -fx; m[6] = -fy; m[10] = -fz; m[14] =  (fx*ex + fy*ey + fz*ez);
+    m[3] = 0;   m[7] = 0;   m[11] = 0;   m[15] = 1;
+}
+
+// Equivalente a glRotatef(pitch,1,0,0); glRotatef(yaw,0,1,0); glTranslatef(-x,-y,-z) (cámara libre)
+inline void mat4FreeLook(float pitch_deg, float yaw_deg, float x, float y, float z, float *m){
+    float p = pitch_deg * 3.14159265f / 180.0f, q = yaw_deg * 3.14159265f / 180.0f;
+    float cp = cosf(p), sp = sinf(p), cq = cosf(q), sq = sinf(q);
+    // Rx(pitch) * Ry(yaw), en orden de columnas
+    m[0] = cq;       m[4] = 0;   m[8]  = sq;
+    m[1] = sp*sq;    m[5] = cp;  m[9]  = -sp*cq;
+    m[2] = -cp*sq;   m[6] = sp;  m[10] = cp*cq;
+    m[3] = 0;        m[7] = 0;   m[11] = 0;        m[15] = 1;
+    m[12] = -(m[0]*x + m[4]*y + m[8]*z);
+    m[13] = -(m[1]*x + m[5]*y + m[9]*z);
+    m[14] = -(m[2]*x + m[6]*y + m[10]*z);
+}
+
+// Framebuffer RGBA en floats con mezcla aditiva (equivale a glBlendFunc(GL_ONE,GL_ONE))
+struct HeadlessFramebuffer {
+    int w = 0, h = 0;
+    std::vector<float> rgba;
+    float mvp[16];
+
+    void resize(int width, int height){
+        w = width; h = height;
+        rgba.assign((size_t)w * h * 4, 0.0f);
+    }
+
+    void clear(float r, float g, float b, float a){
+        for(size_t i = 0; i < rgba.size(); i += 4){
+            rgba[i] = r; rgba[i+1] = g; rgba[i+2] = b; rgba[i+3] = a;
+        }
+    }
+
+    // Misma proyección que proj() y misma cámara orbital que camera_control()
+    void setCamera(float time_T){
+        float P[16], V[16];
+        mat4Perspective(72.0f, (float)w / (float)h, 0.1f, 6000.0f, P);
+        float r = 28.f + 7.f*sinf(0.32f*time_T);
+        float a = 0.3f*time_T;
+        float hh = 3.8f + 2.8f*sinf(0.21f*time_T + 0.9f);
+        mat4LookAt(r*cosf(a), hh, r*sinf(a), 0, 0, -260, 0, 1, 0, V);
+        mat4Mul(P, V, mvp);
+    }
+
+    // Proyecta un punto y lo acumula en el píxel correspondiente. Descarta los puntos detrás de la
+    // cámara (w <= 0), fuera de los planos cercano/lejano y los que caen fuera de la pantalla
+    inline void splat(float x, float y, float z, float r, float g, float b, float a){
+        float cw = mvp[3]*x + mvp[7]*y + mvp[11]*z + mvp[15];
+        if(cw <= 0.0f) return;
+        float cz = mvp[2]*x + mvp[6]*y + mvp[10]*z + mvp[14];
+        if(cz < -cw || cz > cw) return;
+        float inv = 1.0f / cw;
+        float nx = (mvp[0]*x + mvp[4]*y + mvp[8]*z + mvp[12]) * inv;
+        float ny = (mvp[1]*x + mvp[5]*y + mvp[9]*z + mvp[13]) * inv;
+        int px = (int)((nx * 0.5f + 0.5f) * w);
+        int py = (int)((ny * 0.5f + 0.5f) * h);
+        if(px < 0 || px >= w || py < 0 || py >= h) return;
+        float *dst = &rgba[((size_t)py * w + px) * 4];
+        dst[0] += r; dst[1] += g; dst[2] += b; dst[3] += a;
+    }
+
+    // Suma del color saturado a [0,1], como lo guardaría un framebuffer de 8 bits.
+    // Sirve para comparar ejecuciones y evita que el compilador descarte el trabajo.
+    double checksum() const {
+        double sum = 0.0;
+        for(size_t i = 0; i < rgba.size(); i += 4){
+            sum += fminf(rgba[i], 1.f) + fminf(rgba[i+1], 1.f) + fminf(rgba[i+2], 1.f);
+        }
+        return sum;
+    }
+};
+
+// Línea del reporte de tiempos por etapa
+inline void printHeadlessStage(const char *name, double seconds, int frames){
+    printf("   • %-28s %9.3f ms/frame\n", name, frames > 0 ? seconds / frames * 1000.0 : 0.0);
+}
+
+// Percentil por rango más cercano (q en [0,100]) de una muestra de tiempos; reordena la copia
+inline double samplePercentile(std::vector<double> v, double q){
+    if(v.empty()) return 0.0;
+    size_t k = (size_t)ceil(q / 100.0 * v.size());
+    k = k > 0 ? k - 1 : 0;
+    if(k >= v.size()) k = v.size() - 1;
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+// Resumen de un escalón de --ramp: latencia de los frames [begin, end) medidos con esa cantidad
+inline void printRampLevel(int particles, const std::vector<double> &frame_seconds, size_t begin){
+    std::vector<double> level(frame_seconds.begin() + begin, frame_seconds.end());
+    if(level.empty()) return;
+    double sum = 0.0;
+    for(double t : level) sum += t;
+    printf("RAMP particles=%d frames=%zu mean_ms=%.4f p50_ms=%.4f p95_ms=%.4f fps=%.1f\n",
+           particles, level.size(), sum / level.size() * 1000.0,
+           samplePercentile(level, 50.0) * 1000.0, samplePercentile(level, 95.0) * 1000.0,
+           sum > 0.0 ? level.size() / sum : 0.0);
+    fflush(stdout);
+}
+
+// Línea de resultados para el barrido (screensaver-sweep): "BENCH clave=valor ..." en ms por frame,
+// con la huella de los datos generados (la misma en ambas versiones; el barrido la compara).
+// El formato es estable; se agregan claves al final sin cambiar las existentes.
+inline void printBenchLine(const char *version, int particles, int iterations, int threads,
+                           const std::vector<double> &frame_seconds, double checksum, uint64_t fingerprint){
+    double sum = 0.0, mx = 0.0;
+    for(double t : frame_seconds){ sum += t; mx = std::max(mx, t); }
+    size_t n = frame_seconds.size();
+    printf("BENCH version=%s particles=%d iterations=%d threads=%d frames=%zu "
+           "mean_ms=%.4f p50_ms=%.4f p95_ms=%.4f p99_ms=%.4f max_ms=%.4f checksum=%.1f fingerprint=%016llx\n",
+           version, particles, iterations, threads, n,
+           n > 0 ? sum / n * 1000.0 : 0.0,
+           samplePercentile(frame_seconds, 50.0) * 1000.0,
+           samplePercentile(frame_seconds, 95.0) * 1000.0,
+           samplePercentile(frame_seconds, 99.0) * 1000.0,
+           mx * 1000.0, checksum, (unsigned long long)fingerprint);
+    fflush(stdout);
+}
+
+// Latencias de los frames medidos (sin los de calentamiento) para los percentiles y los escalones de --ramp
+struct HeadlessFrames {
+    std::vector<double> seconds;
+
+    explicit HeadlessFrames(const HeadlessConfig &c) : cfg(c) { seconds.reserve(c.frames); }
+
+    // Registra el frame f; al cerrar un escalón de la rampa lo resume y, si quedan frames, llama a
+    // grow() para agregar partículas (fuera del tiempo del frame)
+    template<class Grow>
+    void record(int f, double frame_seconds, int particles, Grow &&grow){
+        if(f < cfg.warmup) return;
+        seconds.push_back(frame_seconds);
+        if(cfg.ramp > 0 && seconds.size() % cfg.ramp == 0){
+            printRampLevel(particles, seconds, seconds.size() - cfg.ramp);
+            if(f + 1 < cfg.warmup + cfg.frames) grow();
+        }
+    }
+
+    // Escalón incompleto al final de la rampa
+    void finish(int particles) const {
+        if(cfg.ramp > 0 && seconds.size() % cfg.ramp != 0){
+            printRampLevel(particles, seconds, seconds.size() - seconds.size() % cfg.ramp);
+        }
+    }
+
+    void printPercentiles() const {
+        if(seconds.empty()) return;
+        printf("   • Frame p50 / p95 / p99 / máx    %.3f / %.3f / %.3f / %.3f ms\n",
+               samplePercentile(seconds, 50.0) * 1000.0, samplePercentile(seconds, 95.0) * 1000.0,
+               samplePercentile(seconds, 99.0) * 1000.0, *std::max_element(seconds.begin(), seconds.end()) * 1000.0);
+    }
+
+private:
+    const HeadlessConfig &cfg;
+};
@@ -0,0 +1,90 @@
+// Contexto OpenGL sin ventana para el modo headless (--headless --gl).
+// Usa EGL "surfaceless" de Mesa y dibuja en un FBO, así el camino GL real (inmediato o VBO)
+// se puede medir en máquinas sin GPU ni servidor X (llvmpipe/softpipe).
+// Se debe incluir después de las cabeceras de GL. Solo disponible en Linux con EGL.
+#pragma once
+
+// SCREENSAVER_NO_EGL lo define el build cuando no encuentra libEGL.
+#if defined(__linux__) && defined(__has_include) && !defined(SCREENSAVER_NO_GL) && !defined(SCREENSAVER_NO_EGL)
+#if __has_include(<EGL/egl.h>)
+#define HEADLESS_GL_AVAILABLE 1
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+#endif
+
+#ifdef HEADLESS_GL_AVAILABLE
+
+#include <cstdio>
+#include <vector>
+
+struct HeadlessGLContext {
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+    GLuint fbo = 0, color_rb = 0, depth_rb = 0;
+    int w = 0, h = 0;
+
+    // Crea el contexto (perfil de compatibilidad) y un FBO RGBA8 + profundidad de w x h
+    bool create(int width, int height){
+        w = width; h = height;
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if(getPlatformDisplay) display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        if(display == EGL_NO_DISPLAY) display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if(display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)){
+            fprintf(stderr, "EGL: no se pudo inicializar el display\n");
+            return false;
+        }
+        eglBindAPI(EGL_OPENGL_API);
+
+        EGLint attrs[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+        EGLConfig config;
+        EGLint num_configs = 0;
+        eglChooseConfig(display, attrs, &config, 1, &num_configs);
+        context = eglCreateContext(display, num_configs > 0 ? config : NULL, EGL_NO_CONTEXT, NULL);
+        if(context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)){
+            fprintf(stderr, "EGL: no se pudo crear el contexto OpenGL\n");
+            return false;
+        }
+
+        glGenRenderbuffers(1, &color_rb);
+        glBindRenderbuffer(GL_RENDERBUFFER, color_rb);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+        glGenRenderbuffers(1, &depth_rb);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth_rb);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_rb);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_rb);
+        if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+            fprintf(stderr, "EGL: FBO incompleto\n");
+            return false;
+        }
+        glDrawBuffer(GL_COLOR_ATTACHMENT0);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        return true;
+    }
+
+    const char* renderer() const { return (const char*)glGetString(GL_RENDERER); }
+
+    // Suma del color del FBO en [0,1] (mismo criterio que HeadlessFramebuffer::checksum)
+    double checksum() const {
+        std::vector<unsigned char> px((size_t)w * h * 4);
+        glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, px.data());
+        double sum = 0.0;
+        for(size_t i = 0; i < px.size(); i += 4) sum += (px[i] + px[i+1] + px[i+2]) / 255.0;
+        return sum;
+    }
+
+    void destroy(){
+        if(display == EGL_NO_DISPLAY) return;
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if(context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+        eglTerminate(display);
+        display = EGL_NO_DISPLAY;
+        context = EGL_NO_CONTEXT;
+    }
+};
+
+#endif
@@ -0,0 +1,135 @@
+// Carga matemática de gen() (HEAVY_MATH_MODE): referencia escalar con libm, versión SIMD con las
+// funciones de simd.h y el modo de validación (--validate-math) que compara ambas por partícula.
+// Compartido por screensaver.cpp y screensaver-paralelo.cpp para que las dos hagan el mismo trabajo.
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include "simd.h"
+
+// Referencia: el bucle original de gen() con sinf/cosf/tanf/powf/expf/logf/atanf/sinhf
+inline void heavyMathScalar(float &a, float &jx, float z, float r, float spd, float band, float jy, int iterations){
+    for(int iter = 0; iter < iterations; iter++){
+        float complexity_factor = 1.0f + iter * 0.1f;
+        float dummy = 0;
+
+        dummy += sinf(a * complexity_factor) * cosf(z * complexity_factor);
+        dummy += tanf(r * 0.01f + iter) * sinf(spd * 0.001f);
+        dummy += sqrtf(fabsf(r * complexity_factor + 1));
+        dummy += powf(fabsf(spd), 1.2f + 0.05f * iter);
+        dummy += expf(-fabsf(jx) * 0.1f) * logf(fabsf(jy) + 1.0f);
+        dummy += atanf(band + iter) * sinhf(a * 0.1f);
+
+        // Pequeño bucle extra para variar la carga
+        for(int j = 0; j < 3; j++){
+            dummy += cosf(a + j) * sinf(z + j);
+        }
+
+        // Perturbación leve de parámetros (no afecta estética)
+        a += dummy * 0.0001f;
+        jx += dummy * 0.00005f;
+    }
+}
+
+// Misma carga para SIMD_WIDTH partículas a la vez. cos(a+j) y sin(z+j) del bucle interno se
+// obtienen rotando sincos(a) y sincos(z) por los ángulos constantes j = 1, 2.
+inline void heavyMathSIMD(vfloat &a, vfloat &jx, vfloat z, vfloat r, vfloat spd, vfloat band, vfloat jy, int iterations){
+    const float COS_J[3] = {1.0f, 0.540302306f, -0.416146837f};
+    const float SIN_J[3] = {0.0f, 0.841470985f, 0.909297427f};
+    vfloat abs_spd = vabs(spd);
+    vfloat log_jy = vlog(vabs(jy) + vfloat(1.0f));
+    vfloat sin_spd = vsin(spd * vfloat(0.001f));
+
+    for(int iter = 0; iter < iterations; iter++){
+        float complexity_factor = 1.0f + iter * 0.1f;
+        vfloat cf = vfloat(complexity_factor);
+        vfloat dummy = vfloat(0.0f);
+
+        dummy = dummy + vsin(a * cf) * vcos(z * cf);
+        dummy = dummy + vtan(r * vfloat(0.01f) + vfloat((float)iter)) * sin_spd;
+        dummy = dummy + vsqrt(vabs(r * cf + vfloat(1.0f)));
+        dummy = dummy + vpow(abs_spd, vfloat(1.2f + 0.05f * iter));
+        dummy = dummy + vexp(vabs(jx) * vfloat(-0.1f)) * log_jy;
+        dummy = dummy + vatan(band + vfloat((float)iter)) * vsinh(a * vfloat(0.1f));
+
+        vfloat sa, ca, sz, cz;
+        vsincos(a, sa, ca);
+        vsincos(z, sz, cz);
+        for(int j = 0; j < 3; j++){
+            dummy = dummy + (ca * vfloat(COS_J[j]) - sa * vfloat(SIN_J[j])) * (sz * vfloat(COS_J[j]) + cz * vfloat(SIN_J[j]));
+        }
+
+        a = a + dummy * vfloat(0.0001f);
+        jx = jx + dummy * vfloat(0.00005f);
+    }
+}
+
+// Aplica la carga SIMD a count <= SIMD_WIDTH partículas consecutivas de arreglos SoA
+// (sin requisitos de alineación; solo se escriben las count partículas válidas)
+inline void heavyMathBlock(float *a, float *jx, const float *z, const float *r, const float *spd,
+                           const float *band, const float *jy, int count, int iterations){
+    alignas(SIMD_ALIGN) float A[SIMD_WIDTH] = {}, JX[SIMD_WIDTH] = {}, Z[SIMD_WIDTH] = {}, R[SIMD_WIDTH] = {};
+    alignas(SIMD_ALIGN) float SPD[SIMD_WIDTH] = {}, BAND[SIMD_WIDTH] = {}, JY[SIMD_WIDTH] = {};
+    for(int l = 0; l < count; l++){
+        A[l] = a[l]; JX[l] = jx[l]; Z[l] = z[l]; R[l] = r[l];
+        SPD[l] = spd[l]; BAND[l] = band[l]; JY[l] = jy[l];
+    }
+    vfloat va = vload(A), vjx = vload(JX);
+    heavyMathSIMD(va, vjx, vload(Z), vload(R), vload(SPD), vload(BAND), vload(JY), iterations);
+    vstore(A, va);
+    vstore(JX, vjx);
+    for(int l = 0; l < count; l++){ a[l] = A[l]; jx[l] = JX[l]; }
+}
+
+// Validación: recalcula cada partícula con libm desde sus valores iniciales y compara a/jx.
+// Error = |rápido - libm| / max(1, |libm|); la tolerancia cubre la amplificación de las
+// iteraciones (a realimenta sin(a*cf) y sinh(a*0.1)).
+// Con muchas iteraciones (>~35) el término powf hace crecer a sin límite, sinh(a*0.1) desborda y a
+// termina en inf/NaN también con libm. Las partículas cuyo a de referencia sale de |a| <= 1000
+// (donde a*cf supera el rango de vsincos y la trayectoria es caótica) se cuentan aparte.
+const double HEAVY_MATH_TOLERANCE = 1e-3;
+const float HEAVY_MATH_DOMAIN = 1000.0f;
+
+struct HeavyMathCheck {
+    size_t count = 0;
+    size_t out_of_tolerance = 0;
+    size_t out_of_domain = 0;       // a de referencia no finito o con |a| > HEAVY_MATH_DOMAIN
+    double max_err_a = 0.0, max_err_jx = 0.0;
+
+    static double error(float fast, float ref){
+        if(!std::isfinite(fast)) return INFINITY;
+        return fabs((double)fast - (double)ref) / fmax(1.0, fabs((double)ref));
+    }
+
+    void check(float a0, float jx0, float z, float r, float spd, float band, float jy, int iterations,
+               float a_fast, float jx_fast){
+        float a = a0, jx = jx0;
+        heavyMathScalar(a, jx, z, r, spd, band, jy, iterations);
+        count++;
+        if(!(fabsf(a) <= HEAVY_MATH_DOMAIN) || !std::isfinite(jx)){
+            out_of_domain++;
+            return;
+        }
+        double ea = error(a_fast, a), ej = error(jx_fast, jx);
+        if(ea > max_err_a) max_err_a = ea;
+        if(ej > max_err_jx) max_err_jx = ej;
+        if(ea > HEAVY_MATH_TOLERANCE || ej > HEAVY_MATH_TOLERANCE) out_of_tolerance++;
+    }
+
+    void merge(const HeavyMathCheck &o){
+        count += o.count;
+        out_of_tolerance += o.out_of_tolerance;
+        out_of_domain += o.out_of_domain;
+        max_err_a = fmax(max_err_a, o.max_err_a);
+        max_err_jx = fmax(max_err_jx, o.max_err_jx);
+    }
+
+    bool ok() const { return out_of_tolerance == 0; }
+
+    void print() const {
+        printf("Validación de la carga matemática (SIMD vs libm, tolerancia %.0e):\n", HEAVY_MATH_TOLERANCE);
+        printf("   • Partículas comparadas: %zu (fuera de dominio, sin comparar: %zu)\n", count - out_of_domain, out_of_domain);
+        printf("   • Error máximo en a: %.3e | en jx: %.3e\n", max_err_a, max_err_jx);
+        printf("   • Fuera de tolerancia: %zu -> %s\n", out_of_tolerance, ok() ? "OK" : "FALLA");
+    }
+};
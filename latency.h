@@ -0,0 +1,92 @@
+// Histograma de latencias estilo HDR: cubetas log-lineales en microsegundos con 32 subdivisiones
+// por potencia de 2 (error relativo < 3.2%), de 1 µs a ~12 días. Registrar un frame es O(1)
+// y sin reservas de memoria, así que se puede actualizar en cada frame del bucle de render.
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <ostream>
+
+struct LatencyHistogram {
+    static const int SUB_BITS = 5;
+    static const int SUB = 1 << SUB_BITS;
+    static const int BANDS = 36;
+    uint64_t counts[BANDS * SUB] = {};
+    uint64_t total = 0;
+    uint64_t sum_us = 0;
+    uint64_t max_us = 0;
+
+    static int indexOf(uint64_t us){
+        if(us < (uint64_t)SUB) return (int)us;
+        int e = 63 - __builtin_clzll(us);
+        int idx = (e - SUB_BITS + 1) * SUB + (int)((us >> (e - SUB_BITS)) - SUB);
+        return idx < BANDS * SUB ? idx : BANDS * SUB - 1;
+    }
+
+    // Mayor valor (µs) que cae en la cubeta idx
+    static uint64_t upperOf(int idx){
+        int band = idx / SUB, sub = idx % SUB;
+        if(band == 0) return (uint64_t)sub;
+        return (((uint64_t)(SUB + sub + 1)) << (band - 1)) - 1;
+    }
+
+    void record(double seconds){
+        uint64_t us = seconds > 0.0 ? (uint64_t)(seconds * 1.0e6 + 0.5) : 0;
+        counts[indexOf(us)]++;
+        total++;
+        sum_us += us;
+        if(us > max_us) max_us = us;
+    }
+
+    // Percentil q en [0,100] en ms (valor más alto equivalente de la cubeta)
+    double percentileMs(double q) const {
+        if(total == 0) return 0.0;
+        uint64_t target = (uint64_t)(q / 100.0 * total + 0.999999);
+        if(target < 1) target = 1;
+        uint64_t seen = 0;
+        for(int i = 0; i < BANDS * SUB; i++){
+            seen += counts[i];
+            if(seen >= target){
+                uint64_t v = upperOf(i);
+                return (v < max_us ? v : max_us) / 1000.0;
+            }
+        }
+        return max_us / 1000.0;
+    }
+
+    double meanMs() const { return total ? (double)sum_us / total / 1000.0 : 0.0; }
+    double maxMs() const { return max_us / 1000.0; }
+
+    void reset(){ *this = LatencyHistogram(); }
+};
+
+// Un histograma por etapa del frame (la etapa 0 es el frame completo)
+struct LatencyStages {
+    static const int MAX_STAGES = 8;
+    int count = 0;
+    const char *names[MAX_STAGES] = {};
+    LatencyHistogram hist[MAX_STAGES];
+
+    LatencyStages(std::initializer_list<const char*> stage_names){
+        for(const char *n : stage_names) if(count < MAX_STAGES) names[count++] = n;
+    }
+
+    void record(int stage, double seconds){ hist[stage].record(seconds); }
+    void reset(){ for(int i = 0; i < count; i++) hist[i].reset(); }
+
+    // Tabla p50/p95/p99/máx por etapa (ms), para el archivo de métricas y la consola.
+    // Las etapas sin muestras (opcionales, como la del pipeline) se omiten.
+    void writeReport(std::ostream &out) const {
+        char line[160];
+        snprintf(line, sizeof(line), "%-22s %9s %9s %9s %9s %9s\n", "Etapa (ms)", "media", "p50", "p95", "p99", "máx");
+        out << line;
+        for(int i = 0; i < count; i++){
+            const LatencyHistogram &h = hist[i];
+            if(i > 0 && h.total == 0) continue;
+            snprintf(line, sizeof(line), "%-22s %9.3f %9.3f %9.3f %9.3f %9.3f\n", names[i],
+                     h.meanMs(), h.percentileMs(50), h.percentileMs(95), h.percentileMs(99), h.maxMs());
+            out << line;
+        }
+    }
+};
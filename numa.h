@@ -0,0 +1,226 @@
+// Ubicación NUMA de los buffers y afinidad de los hilos OpenMP (Linux; en otros sistemas todo
+// se reduce a un nodo y sin fijar hilos). Sin libnuma: la topología sale de /sys y la ubicación de
+// las páginas de move_pages(2) en modo consulta.
+//
+// Primer toque: el kernel ubica cada página en el nodo del hilo que la escribe primero. Los buffers
+// grandes se reservan sin inicializar y cada hilo escribe primero su tramo de la partición estática
+// de los kernels, así cada hilo lee y escribe memoria de su propio nodo. Para que esto sirva, los
+// hilos tienen que quedar fijos en sus CPUs (--affinity) antes del primer toque.
+#pragma once
+
+#include <omp.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#ifdef __linux__
+#include <dirent.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
+enum ThreadAffinity { AFFINITY_NONE, AFFINITY_COMPACT, AFFINITY_SPREAD };
+
+inline const char *affinityName(ThreadAffinity mode){
+    switch(mode){
+        case AFFINITY_COMPACT: return "compact";
+        case AFFINITY_SPREAD: return "spread";
+        default: return "sin fijar";
+    }
+}
+
+// Asignador que construye por defecto en vez de inicializar a cero: al redimensionar no se
+// escribe nada y las páginas quedan libres para el primer toque paralelo
+template<class T>
+struct FirstTouchAllocator : std::allocator<T> {
+    template<class U> struct rebind { using other = FirstTouchAllocator<U>; };
+    FirstTouchAllocator() = default;
+    template<class U> FirstTouchAllocator(const FirstTouchAllocator<U>&){}
+
+    template<class U> void construct(U *p){ ::new((void*)p) U; }
+    template<class U, class... Args> void construct(U *p, Args&&... args){ ::new((void*)p) U(std::forward<Args>(args)...); }
+};
+
+// Tramo [u0,u1) del hilo tid en la partición estática de `units` unidades (la de los kernels)
+inline void staticRange(size_t units, int tid, int nth, size_t &u0, size_t &u1){
+    u0 = units * tid / nth;
+    u1 = units * (tid + 1) / nth;
+}
+
+inline int numaNodeCount(){
+#ifdef __linux__
+    DIR *dir = opendir("/sys/devices/system/node");
+    if(!dir) return 1;
+    int nodes = 0;
+    while(struct dirent *e = readdir(dir)){
+        if(strncmp(e->d_name, "node", 4) == 0 && e->d_name[4] >= '0' && e->d_name[4] <= '9') nodes++;
+    }
+    closedir(dir);
+    return std::max(1, nodes);
+#else
+    return 1;
+#endif
+}
+
+// Nodo de una CPU según el enlace /sys/devices/system/cpu/cpuN/nodeM (0 si no hay)
+inline int numaNodeOfCpu(int cpu){
+#ifdef __linux__
+    std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    DIR *dir = opendir(path.c_str());
+    if(!dir) return 0;
+    int node = 0;
+    while(struct dirent *e = readdir(dir)){
+        if(strncmp(e->d_name, "node", 4) == 0 && e->d_name[4] >= '0' && e->d_name[4] <= '9') node = atoi(e->d_name + 4);
+    }
+    closedir(dir);
+    return node;
+#else
+    (void)cpu;
+    return 0;
+#endif
+}
+
+// CPU y nodo en que corre el hilo que llama
+inline void currentCpuNode(int &cpu, int &node){
+    cpu = 0;
+    node = 0;
+#ifdef __linux__
+    unsigned c = 0, n = 0;
+    if(syscall(SYS_getcpu, &c, &n, nullptr) == 0){
+        cpu = (int)c;
+        node = (int)n;
+    }
+#endif
+}
+
+// CPUs permitidas al proceso en el orden en que se asignan a los hilos: compact llena un nodo
+// antes de pasar al siguiente; spread alterna entre nodos (hilo i en el nodo i % nodos)
+inline std::vector<int> affinityCpuOrder(ThreadAffinity mode){
+    std::vector<int> order;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if(sched_getaffinity(0, sizeof(set), &set) != 0) return order;
+    std::vector<std::vector<int>> by_node;
+    for(int cpu = 0; cpu < CPU_SETSIZE; cpu++){
+        if(!CPU_ISSET(cpu, &set)) continue;
+        int node = numaNodeOfCpu(cpu);
+        if(node >= (int)by_node.size()) by_node.resize(node + 1);
+        by_node[node].push_back(cpu);
+    }
+    if(mode == AFFINITY_COMPACT){
+        for(const auto &cpus : by_node) order.insert(order.end(), cpus.begin(), cpus.end());
+    } else {
+        for(size_t i = 0; ; i++){
+            bool any = false;
+            for(const auto &cpus : by_node){
+                if(i < cpus.size()){
+                    order.push_back(cpus[i]);
+                    any = true;
+                }
+            }
+            if(!any) break;
+        }
+    }
+#else
+    (void)mode;
+#endif
+    return order;
+}
+
+// Fija cada hilo del equipo de `threads` hilos a una CPU. El runtime reutiliza los mismos hilos en
+// las regiones siguientes (los equipos más chicos toman los primeros), así que basta una vez.
+// Devuelve false si no se pudo (sin soporte o sin permiso).
+inline bool pinOpenMPThreads(ThreadAffinity mode, int threads){
+    if(mode == AFFINITY_NONE) return false;
+#ifdef __linux__
+    std::vector<int> order = affinityCpuOrder(mode);
+    if(order.empty()) return false;
+    int failed = 0;
+    #pragma omp parallel num_threads(threads) reduction(+:failed)
+    {
+        cpu_set_t one;
+        CPU_ZERO(&one);
+        CPU_SET(order[omp_get_thread_num() % order.size()], &one);
+        if(sched_setaffinity(0, sizeof(one), &one) != 0) failed++;
+    }
+    return failed == 0;
+#else
+    (void)threads;
+    return false;
+#endif
+}
+
+// Primer toque de `count` floats por bloques de `block`: cada hilo copia su tramo de src (los
+// primeros `copy` elementos) y deja en cero el resto
+inline void firstTouchFloats(float *dst, const float *src, size_t copy, size_t count, size_t block, int threads){
+    const size_t units = (count + block - 1) / block;
+    #pragma omp parallel num_threads(threads)
+    {
+        size_t u0, u1;
+        staticRange(units, omp_get_thread_num(), omp_get_num_threads(), u0, u1);
+        size_t i0 = std::min(count, u0 * block), i1 = std::min(count, u1 * block);
+        size_t c1 = std::max(i0, std::min(i1, copy));
+        if(src && c1 > i0) memcpy(dst + i0, src + i0, (c1 - i0) * sizeof(float));
+        if(i1 > c1) memset(dst + c1, 0, (i1 - c1) * sizeof(float));
+    }
+}
+
+// Primer toque de un mapeo privado (MAP_PRIVATE) ya escrito: reescribir un valor por página hace
+// que la copia privada de la página se cree en el nodo del hilo que la procesa
+inline void firstTouchInPlace(float *p, size_t count, size_t block, int threads){
+    const size_t units = (count + block - 1) / block;
+    const uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    #pragma omp parallel num_threads(threads)
+    {
+        size_t u0, u1;
+        staticRange(units, omp_get_thread_num(), omp_get_num_threads(), u0, u1);
+        size_t i1 = std::min(count, u1 * block);
+        volatile float *v = p;
+        for(size_t i = u0 * block; i < i1; ){
+            v[i] = v[i];
+            uintptr_t next_page = ((uintptr_t)(p + i) / page + 1) * page;
+            i = (next_page - (uintptr_t)p) / sizeof(float);
+        }
+    }
+}
+
+// Primer toque de `slices` porciones de `stride` elementos (un pase por porción): cada hilo
+// inicializa su parte de cada porción
+template<class T>
+void firstTouchSlices(T *base, size_t slices, size_t stride, int threads){
+    #pragma omp parallel num_threads(threads)
+    {
+        size_t e0, e1;
+        staticRange(stride, omp_get_thread_num(), omp_get_num_threads(), e0, e1);
+        for(size_t s = 0; s < slices; s++) memset((void*)(base + s * stride + e0), 0, (e1 - e0) * sizeof(T));
+    }
+}
+
+// Nodo de cada página de [base, base+bytes) (move_pages sin destino solo consulta); las páginas
+// sin memoria física o sin información quedan en -1. Devuelve false si el sistema no lo soporta.
+inline bool numaPageNodes(const void *base, size_t bytes, std::vector<int> &nodes){
+    nodes.clear();
+#ifdef __linux__
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    uintptr_t first = (uintptr_t)base / page * page;
+    size_t count = ((uintptr_t)base + bytes - first + page - 1) / page;
+    std::vector<void*> pages(count);
+    for(size_t i = 0; i < count; i++) pages[i] = (void*)(first + i * page);
+    nodes.assign(count, -1);
+    if(syscall(SYS_move_pages, 0, (unsigned long)count, pages.data(), nullptr, nodes.data(), 0) != 0){
+        nodes.clear();
+        return false;
+    }
+    for(int &n : nodes) if(n < 0) n = -1;
+    return true;
+#else
+    (void)base; (void)bytes;
+    return false;
+#endif
+}
@@ -0,0 +1,159 @@
+// Tabla de paleta por frame (--palette N). colorBH() solo depende de (u, v, T) con u en (-1, 1) y
+// v en [0, V_MAX], pero cuesta tres senos por partícula. Con la tabla, cada frame se evalúa la
+// paleta exacta en una grilla de N x N puntos de (u, v) y los kernels de pases interpolan
+// bilinealmente entre los 4 vecinos (12 lecturas en lugar de 3 senos).
+//
+// Al armarla se mide el error contra la paleta exacta en el centro de cada celda (donde la
+// interpolación bilineal se aleja más de una función suave): máximo de |exacto - tabla| entre los
+// tres canales, en unidades de color [0, 1]. Más resolución: menos error y más tabla que armar.
+#pragma once
+
+#include <omp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include "simd.h"
+#include "pass_engine.h"
+
+// Paleta animada en versión vectorial (misma fórmula que colorBH)
+inline void colorBHv(vfloat u, vfloat v, vfloat &r, vfloat &g, vfloat &b, float time_T){
+    vfloat c1=vfloat(0.5f)+vfloat(0.5f)*vsin(vfloat(6.2831853f)*(u+vfloat(0.05f*time_T)));
+    vfloat c2=vfloat(0.5f)+vfloat(0.5f)*vsin(vfloat(6.2831853f)*(u*vfloat(0.5f)+vfloat(0.3f)*v)+vfloat(2.1f+0.1f*time_T));
+    vfloat c3=vfloat(0.5f)+vfloat(0.5f)*vsin(vfloat(6.2831853f)*(u*vfloat(0.9f)-vfloat(0.2f)*v)+vfloat(3.6f-0.07f*time_T));
+    vfloat blue = vfloat(0.55f)+vfloat(0.45f)*c1;
+    vfloat purple = vfloat(0.45f)+vfloat(0.55f)*c2;
+    vfloat pink = vfloat(0.55f)+vfloat(0.45f)*c3;
+    r = vfloat(0.25f)*blue + vfloat(0.35f)*purple + vfloat(0.80f)*pink;
+    g = vfloat(0.35f)*blue + vfloat(0.45f)*purple + vfloat(0.30f)*pink;
+    b = vfloat(1.00f)*blue + vfloat(0.60f)*purple + vfloat(0.20f)*pink;
+}
+
+class PaletteLUT {
+public:
+    // Dominio de (u, v): u = fmod(0.0025*z + 0.12*band, 1) tiene el signo de z; v = |z|/1400
+    // hasta la profundidad más lejana de los pases (fuera de él se satura al borde)
+    static constexpr float U_MIN = -1.f, U_MAX = 1.f;
+    static constexpr float V_MAX = std::max(-passesZFar(0, PASS_COUNT), passesZNear(0, PASS_COUNT)) / 1400.f;
+
+    PaletteLUT() = default;
+    PaletteLUT(const PaletteLUT &o){ *this = o; }
+    ~PaletteLUT(){ release(); }
+
+    // Copia profunda (los juegos del pipeline se crean copiando uno vacío)
+    PaletteLUT &operator=(const PaletteLUT &o){
+        if(this == &o) return *this;
+        allocate(o.res);
+        for(int c = 0; c < 3; c++) if(o.rgb[c]) memcpy(rgb[c], o.rgb[c], (size_t)pitch * res * sizeof(float));
+        max_error = o.max_error;
+        return *this;
+    }
+
+    int resolution() const { return res; }
+    float maxError() const { return max_error; }
+
+    // Evalúa la paleta exacta en el instante T sobre la grilla de res x res (res >= 2) y mide el error
+    void build(int resolution, float T, int threads){
+        if(std::max(2, resolution) != res) allocate(std::max(2, resolution));
+        float *R = rgb[0], *G = rgb[1], *B = rgb[2];
+        float err = 0.f;
+        #pragma omp parallel num_threads(threads)
+        {
+            // Filas completas en vectores; las columnas de relleno (hasta pitch) no se leen nunca
+            #pragma omp for schedule(static)
+            for(int j = 0; j < res; j++){
+                for(int i = 0; i < pitch; i += SIMD_WIDTH){
+                    vfloat r, g, b;
+                    colorBHv(columnU(i, 0.f), vfloat(j * dv), r, g, b, T);
+                    size_t at = (size_t)j * pitch + i;
+                    vstore(R + at, r); vstore(G + at, g); vstore(B + at, b);
+                }
+            }
+
+            // Error en el centro de cada celda (la barrera implícita del for deja la tabla completa)
+            #pragma omp for schedule(static) reduction(max:err)
+            for(int j = 0; j < res - 1; j++){
+                const vfloat v = vfloat((j + 0.5f) * dv);
+                for(int i = 0; i < res - 1; i += SIMD_WIDTH){
+                    vfloat er, eg, eb, lr, lg, lb;
+                    const vfloat u = columnU(i, 0.5f);
+                    colorBHv(u, v, er, eg, eb, T);
+                    lookup(u, v, lr, lg, lb);
+                    alignas(SIMD_ALIGN) float d[SIMD_WIDTH];
+                    vstore(d, vmax(vabs(er - lr), vmax(vabs(eg - lg), vabs(eb - lb))));
+                    for(int l = 0; l < std::min(SIMD_WIDTH, res - 1 - i); l++) err = std::max(err, d[l]);
+                }
+            }
+        }
+        max_error = err;
+    }
+
+    // Interpolación bilineal de SIMD_WIDTH puntos (u, v)
+    inline void lookup(vfloat u, vfloat v, vfloat &r, vfloat &g, vfloat &b) const {
+        vfloat fu = vmin(vmax((u - vfloat(U_MIN)) * vfloat(1.f / du), vfloat(0.f)), vfloat((float)(res - 1)));
+        vfloat fv = vmin(vmax(v * vfloat(1.f / dv), vfloat(0.f)), vfloat((float)(res - 1)));
+        vfloat iu = vmin(vtrunc(fu), vfloat((float)(res - 2))), iv = vmin(vtrunc(fv), vfloat((float)(res - 2)));
+        vfloat tu = fu - iu, tv = fv - iv;
+        vint i00 = vcvtt(iv * vfloat((float)pitch) + iu), i01 = i00 + vint(pitch);
+        auto bilinear = [&](const float *c){
+            vfloat c00 = vgather(c, i00), c10 = vgather(c, i00 + vint(1));
+            vfloat c01 = vgather(c, i01), c11 = vgather(c, i01 + vint(1));
+            vfloat c0 = c00 + tu * (c10 - c00), c1 = c01 + tu * (c11 - c01);
+            return c0 + tv * (c1 - c0);
+        };
+        r = bilinear(rgb[0]);
+        g = bilinear(rgb[1]);
+        b = bilinear(rgb[2]);
+    }
+
+    // Misma interpolación para un punto (kernel escalar); misma interfaz que ExactPalette
+    inline void operator()(float u, float v, float &r, float &g, float &b) const {
+        float fu = std::min(std::max((u - U_MIN) * (1.f / du), 0.f), (float)(res - 1));
+        float fv = std::min(std::max(v * (1.f / dv), 0.f), (float)(res - 1));
+        float iu = std::min(truncf(fu), (float)(res - 2)), iv = std::min(truncf(fv), (float)(res - 2));
+        float tu = fu - iu, tv = fv - iv;
+        size_t i00 = (size_t)iv * pitch + (size_t)iu, i01 = i00 + pitch;
+        auto bilinear = [&](const float *c){
+            float c0 = c[i00] + tu * (c[i00 + 1] - c[i00]), c1 = c[i01] + tu * (c[i01 + 1] - c[i01]);
+            return c0 + tv * (c1 - c0);
+        };
+        r = bilinear(rgb[0]);
+        g = bilinear(rgb[1]);
+        b = bilinear(rgb[2]);
+    }
+
+private:
+    int res = 0, pitch = 0;                 // puntos por eje y floats por fila (múltiplo de SIMD_WIDTH)
+    float du = 1.f, dv = 1.f;
+    float max_error = 0.f;
+    float *rgb[3] = {nullptr, nullptr, nullptr};    // canales planos alineados a SIMD_ALIGN (vstore), fila j = v, columna i = u
+
+    // Canales de resolution x resolution (resolution >= 2, o 0: sin tabla), en ceros
+    void allocate(int resolution){
+        release();
+        if(resolution < 2) return;
+        res = resolution;
+        pitch = (res + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+        for(float *&c : rgb){
+            c = simdAllocFloats((size_t)pitch * res);
+            std::fill(c, c + (size_t)pitch * res, 0.f);
+        }
+        du = (U_MAX - U_MIN) / (res - 1);
+        dv = V_MAX / (res - 1);
+    }
+
+    void release(){
+        for(float *&c : rgb){
+            free(c);
+            c = nullptr;
+        }
+        res = pitch = 0;
+    }
+
+    // u de las columnas i..i+SIMD_WIDTH-1 desplazadas `offset` celdas
+    inline vfloat columnU(int i, float offset) const {
+        alignas(SIMD_ALIGN) float u[SIMD_WIDTH];
+        for(int l = 0; l < SIMD_WIDTH; l++) u[l] = U_MIN + (i + l + offset) * du;
+        return vload(u);
+    }
+};
@@ -0,0 +1,157 @@
+// Caché binaria del campo generado por gen(). Las partículas son una función pura de
+// (semilla, cantidad, iteraciones, modo de la carga matemática), así que tras la primera
+// generación se guardan en un archivo versionado y las corridas siguientes lo mapean con mmap:
+// el arranque pasa a ser una carga de páginas bajo demanda en vez de recalcular todo.
+//
+// Formato (little-endian, versión PARTICLE_CACHE_VERSION):
+//   ParticleCacheHeader (tamaño múltiplo de 64 bytes)
+//   7 arreglos float de `capacity` elementos (a, z, r, spd, band, jx, jy), cada uno alineado a 64
+//   bytes y con relleno tras las `count` partículas; luego las estrellas como 7 floats por estrella.
+// La versión paralela apunta su SoA directo al mapeo (MAP_PRIVATE: escribir no toca el archivo).
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "counter_rng.h"
+#include "simd.h"
+
+// Subir al cambiar el formato o cualquier fórmula de gen() (invalida las cachés existentes)
+const uint32_t PARTICLE_CACHE_VERSION = 1;
+const size_t PARTICLE_CACHE_ALIGN = 64;
+const int PARTICLE_CACHE_FIELDS = 7;
+
+// Todo lo que determina el contenido del campo generado
+struct ParticleCacheKey {
+    uint32_t seed_particles = 0, seed_stars = 0;
+    int32_t count = 0, star_count = 0, iterations = 0;
+    int32_t math_mode = 0;          // 0: sin carga, 1: libm escalar, 2: SIMD
+    char backend[16] = {};          // SIMD_NAME: los polinomios pueden diferir entre backends
+
+    bool operator==(const ParticleCacheKey &o) const { return memcmp(this, &o, sizeof(*this)) == 0; }
+};
+
+struct alignas(PARTICLE_CACHE_ALIGN) ParticleCacheHeader {
+    char magic[8];                  // "SSPCACHE"
+    uint32_t version;
+    uint32_t header_bytes;
+    ParticleCacheKey key;
+    uint64_t capacity;              // floats por arreglo de partículas (con relleno)
+    uint64_t file_bytes;
+};
+
+inline ParticleCacheKey particleCacheKey(int count, int star_count, int iterations, int math_mode){
+    ParticleCacheKey key;
+    key.seed_particles = RNG_SEED_PARTICLES;
+    key.seed_stars = RNG_SEED_STARS;
+    key.count = count;
+    key.star_count = star_count;
+    key.iterations = iterations;
+    key.math_mode = math_mode;
+    strncpy(key.backend, SIMD_NAME, sizeof(key.backend) - 1);
+    return key;
+}
+
+inline size_t particleCacheCapacity(size_t count){
+    const size_t per_line = PARTICLE_CACHE_ALIGN / sizeof(float);
+    return ((count + per_line - 1) / per_line) * per_line;
+}
+
+inline std::string particleCachePath(const std::string &dir, const ParticleCacheKey &key){
+    char name[160];
+    snprintf(name, sizeof(name), "particulas_v%u_s%u_n%d_e%d_i%d_m%d_%s.bin", PARTICLE_CACHE_VERSION,
+             key.seed_particles, key.count, key.star_count, key.iterations, key.math_mode, key.backend);
+    return dir.empty() ? std::string(name) : dir + "/" + name;
+}
+
+// Archivo de caché mapeado en memoria
+struct ParticleCacheMap {
+    void *base = nullptr;
+    size_t bytes = 0;
+
+    const ParticleCacheHeader &header() const { return *(const ParticleCacheHeader*)base; }
+    float *field(int f) const {
+        return (float*)((char*)base + sizeof(ParticleCacheHeader)) + (size_t)f * header().capacity;
+    }
+    const float *stars() const { return field(PARTICLE_CACHE_FIELDS); }
+};
+
+inline void particleCacheClose(ParticleCacheMap &map){
+    if(map.base) munmap(map.base, map.bytes);
+    map = ParticleCacheMap();
+}
+
+// Mapea el archivo si existe y corresponde exactamente a la clave; si no, devuelve false
+inline bool particleCacheOpen(const std::string &path, const ParticleCacheKey &key, ParticleCacheMap &map){
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ParticleCacheHeader)){
+        close(fd);
+        return false;
+    }
+    void *base = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED) return false;
+    map.base = base;
+    map.bytes = st.st_size;
+
+    const ParticleCacheHeader &h = map.header();
+    size_t expected = sizeof(ParticleCacheHeader) +
+        (PARTICLE_CACHE_FIELDS * h.capacity + (size_t)key.star_count * PARTICLE_CACHE_FIELDS) * sizeof(float);
+    bool ok = memcmp(h.magic, "SSPCACHE", 8) == 0 && h.version == PARTICLE_CACHE_VERSION &&
+              h.header_bytes == sizeof(ParticleCacheHeader) && h.key == key &&
+              h.capacity == particleCacheCapacity(key.count) && h.file_bytes == map.bytes &&
+              map.bytes == expected;
+    if(!ok){
+        particleCacheClose(map);
+        return false;
+    }
+    // Se leerá todo en orden: que el kernel adelante la lectura
+    madvise(map.base, map.bytes, MADV_SEQUENTIAL);
+    return true;
+}
+
+// Escribe la caché (a un temporal que luego se renombra, para no dejar archivos a medias).
+// get(f, i) devuelve el campo f de la partícula i; pad[f] es el valor de relleno de cada campo.
+template<class FieldGetter>
+bool particleCacheWrite(const std::string &path, const ParticleCacheKey &key, FieldGetter get,
+                        const float pad[PARTICLE_CACHE_FIELDS], const float *stars){
+    const size_t n = key.count, capacity = particleCacheCapacity(n);
+    ParticleCacheHeader h{};        // valor-inicializado: ceros también en el relleno del alineamiento
+    memcpy(h.magic, "SSPCACHE", 8);
+    h.version = PARTICLE_CACHE_VERSION;
+    h.header_bytes = sizeof(ParticleCacheHeader);
+    h.key = key;
+    h.capacity = capacity;
+    h.file_bytes = sizeof(ParticleCacheHeader) +
+        (PARTICLE_CACHE_FIELDS * capacity + (size_t)key.star_count * PARTICLE_CACHE_FIELDS) * sizeof(float);
+
+    size_t slash = path.rfind('/');
+    if(slash != std::string::npos && slash > 0) mkdir(path.substr(0, slash).c_str(), 0755);
+    std::string tmp = path + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if(!f) return false;
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+    std::vector<float> chunk(1 << 14);
+    for(int field = 0; field < PARTICLE_CACHE_FIELDS && ok; field++){
+        for(size_t i0 = 0; i0 < capacity && ok; i0 += chunk.size()){
+            size_t count = std::min(chunk.size(), capacity - i0);
+            for(size_t k = 0; k < count; k++) chunk[k] = i0 + k < n ? get(field, i0 + k) : pad[field];
+            ok = fwrite(chunk.data(), sizeof(float), count, f) == count;
+        }
+    }
+    size_t star_floats = (size_t)key.star_count * PARTICLE_CACHE_FIELDS;
+    if(ok) ok = fwrite(stars, sizeof(float), star_floats, f) == star_floats;
+    ok = fclose(f) == 0 && ok;
+    if(ok) ok = rename(tmp.c_str(), path.c_str()) == 0;
+    if(!ok) remove(tmp.c_str());
+    return ok;
+}
@@ -0,0 +1,57 @@
+// Campo de partículas y estrellas, común a la versión secuencial y a la paralela. Cada elemento es
+// función pura de su índice (RNG por contador, counter_rng.h): cada versión recorre los índices a su
+// manera (un bucle, una región OpenMP, por tramos al cambiar la cantidad) y el campo es el mismo.
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "counter_rng.h"
+#include "pass_engine.h"
+
+// Límites de la cantidad de partículas (argumento, teclas [ ] y --ramp)
+constexpr int PARTICLE_MIN = 10000, PARTICLE_MAX = 1000000;
+
+// Parámetros iniciales de la partícula i, antes de la carga matemática de gen()
+inline Particle initialParticle(int i){
+    CounterRng rng(RNG_SEED_PARTICLES, i);
+    Particle p;
+    p.a=6.2831853f*rng.U();
+    p.z=-1200.f*rng.U()-40.f;
+    p.r=4.f+26.f*powf(rng.U(),0.7f);
+    p.spd=18.f+48.f*rng.U();
+    p.band=floorf(rng.U()*7.f);
+    p.jx=0.6f*rng.S();
+    p.jy=0.6f*rng.S();
+    return p;
+}
+
+// Estrella i; con heavy se le suma la carga extra de la generación original
+inline Particle initialStar(int i, bool heavy){
+    CounterRng rng(RNG_SEED_STARS, i);
+    float a=6.2831853f*rng.U();
+    float R=140.f*sqrtf(rng.U());
+    Particle s={a,-4000.f*rng.U()-200.f,R*cosf(a),10.f+R*sinf(a),14.f+20.f*rng.U(),0.f,0.f};
+    if(heavy) {
+        for(int iter = 0; iter < 5; iter++) {
+            float dummy = sinf(a * iter) + cosf(R * iter) + tanf(s.spd * 0.01f);
+            s.a += dummy * 0.0001f;
+        }
+    }
+    return s;
+}
+
+// Huella de los datos generados (particle(i) da la partícula i de las n del campo): igual en la
+// versión secuencial y la paralela con cualquier número de hilos
+template<class Get>
+uint64_t fieldFingerprint(size_t n, Get &&particle, const std::vector<Particle> &stars){
+    uint64_t h = FINGERPRINT_BASIS;
+    for(size_t i = 0; i < n; i++){
+        const Particle p = particle(i);
+        for(float v : {p.a, p.z, p.r, p.spd, p.band, p.jx, p.jy}) h = fingerprintMix(h, v);
+    }
+    for(const Particle &s : stars){
+        for(float v : {s.a, s.z, s.r, s.spd, s.band, s.jx, s.jy}) h = fingerprintMix(h, v);
+    }
+    return h;
+}
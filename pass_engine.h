@@ -0,0 +1,263 @@
+// Motor de los pases de partículas, común a la versión secuencial y a la paralela:
+//
+//   - Tabla constexpr de los 6 pases: los kernels se instancian por pase (o por los 6 fusionados),
+//     así que rangos de profundidad, giro y alfa son constantes y el bucle de pases se desenrolla.
+//   - Kernel escalar de referencia (cálculo de una partícula y de sus vértices por pase). La versión
+//     secuencial lo corre sobre SequentialBackend; la paralela, en su variante SIMD o escalar.
+//   - Pases compactos en tres fases (conteo por tramo, suma prefija, escritura desde el
+//     desplazamiento del tramo) sobre un backend: secuencial, región OpenMP o grafo de tareas.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+#include "task_graph.h"
+#include "trace.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+struct Particle{float a,z,r,spd,band,jx,jy;};
+
+// Parámetros de cada pase de partículas: tamaño de punto, alfa, rango de profundidad y giro
+struct PassConfig { float ps, alphaMul, znear, zfar, swirl; };
+constexpr int PASS_COUNT = 6;
+constexpr PassConfig PASSES[PASS_COUNT] = {
+    {1.5f, 0.15f, 1200.f, -3000.f, 0.25f},
+    {1.8f, 0.25f,  900.f, -2600.f, 0.35f},
+    {2.2f, 0.40f,  600.f, -2000.f, 0.40f},
+    {2.6f, 0.50f,  280.f, -1200.f, 0.45f},
+    {3.5f, 0.75f,  150.f,  -800.f, 0.50f},
+    {4.2f, 0.95f,   80.f,  -520.f, 0.55f},
+};
+
+using PassCounts = std::array<int, PASS_COUNT>;
+
+// Rango de profundidad que cubre todos los pases [k0,k1) (los rangos se solapan: su unión es un intervalo)
+constexpr float passesZNear(int k0, int k1){
+    float z = PASSES[k0].znear;
+    for(int k = k0 + 1; k < k1; k++) z = PASSES[k].znear > z ? PASSES[k].znear : z;
+    return z;
+}
+
+constexpr float passesZFar(int k0, int k1){
+    float z = PASSES[k0].zfar;
+    for(int k = k0 + 1; k < k1; k++) z = PASSES[k].zfar < z ? PASSES[k].zfar : z;
+    return z;
+}
+
+// Llama f(std::integral_constant<int, K>) para K = K0..K1-1: dentro de f, PASSES[K] es constante
+template<int K0, int K1, class F>
+inline void forPasses(F &&f){
+    if constexpr (K0 < K1) {
+        f(std::integral_constant<int, K0>());
+        forPasses<K0 + 1, K1>(f);
+    }
+}
+
+template<int K>
+constexpr bool passContains(float z){ return z <= PASSES[K].znear && z >= PASSES[K].zfar; }
+
+// Colores de partículas (paleta animada)
+inline void colorBH(float u, float v, float &r, float &g, float &b, float time_T){
+    float c1=0.5f+0.5f*sinf(6.2831853f*(u+0.05f*time_T));
+    float c2=0.5f+0.5f*sinf(6.2831853f*(u*0.5f+0.3f*v)+2.1f+0.1f*time_T);
+    float c3=0.5f+0.5f*sinf(6.2831853f*(u*0.9f-0.2f*v)+3.6f-0.07f*time_T);
+    float blue = 0.55f+0.45f*c1;
+    float purple = 0.45f+0.55f*c2;
+    float pink = 0.55f+0.45f*c3;
+    r = 0.25f*blue + 0.35f*purple + 0.80f*pink;
+    g = 0.35f*blue + 0.45f*purple + 0.30f*pink;
+    b = 1.00f*blue + 0.60f*purple + 0.20f*pink;
+}
+
+// Paleta exacta en el instante T; la tabla por frame (PaletteLUT, palette_lut.h) tiene la misma interfaz
+struct ExactPalette {
+    float T;
+    void operator()(float u, float v, float &r, float &g, float &b) const { colorBH(u, v, r, g, b, T); }
+};
+
+// Profundidad de la partícula en el instante T (avanza hacia la cámara y vuelve a empezar)
+inline float particleDepth(const Particle &p, float T){ return p.z + fmodf(T*p.spd, 1400.f); }
+
+// Términos de una partícula comunes a todos los pases; solo el ángulo depende del pase (swirl)
+struct ParticleTerms { float a0, r, wob, jitx, jity, cr, cg, cb, fade; };
+
+template<class Palette>
+inline ParticleTerms particleTerms(const Particle &p, float z, float T, const Palette &palette){
+    const float INNER_R = 10.0f;
+    ParticleTerms t;
+
+    // Trayectoria y tamaño
+    t.a0=p.a + 0.0019f*z + p.band*(6.2831853f/7.f);
+    t.r=p.r*(1.f+0.0011f*z);
+    if(t.r<INNER_R) t.r=INNER_R;
+
+    // Pequeñas oscilaciones y jitter
+    t.wob=0.8f*sinf(0.7f*T+p.band*0.8f+0.02f*z);
+    t.jitx=p.jx*sinf(0.9f*T+0.01f*z);
+    t.jity=p.jy*cosf(0.8f*T+0.013f*z);
+
+    // Color y transparencia con brillo y desvanecimiento hacia el centro
+    float u=fmodf(0.0025f*z + 0.12f*p.band,1.f);
+    float v=fabsf(z)/1400.f;
+    palette(u,v,t.cr,t.cg,t.cb);
+    float glow=0.6f+0.4f*sinf(2.4f*T+0.3f*p.band+0.003f*z);
+    float centerFade = 0.6f + 0.4f*(t.r/INNER_R);
+    t.fade=(1.f - fminf(1.f,v))*glow*centerFade;
+    return t;
+}
+
+// Kernel escalar de los pases [K0,K1) sobre las partículas [i0,i1). load(i) da la partícula,
+// visible(i, z) el recorte (una lambda que devuelve true si no hay: la rama desaparece) y
+// emit(K, x, y, z, r, g, b, a) recibe cada vértice con el alfa del pase ya aplicado y palette(u, v, r, g, b)
+// da el color (ExactPalette o la tabla del frame).
+template<int K0, int K1, class Load, class Visible>
+PassCounts countPassesScalar(int i0, int i1, float T, Load &&load, Visible &&visible){
+    constexpr float zmax = passesZNear(K0, K1), zmin = passesZFar(K0, K1);
+    PassCounts cnt = {};
+    for(int i = i0; i < i1; i++){
+        float z = particleDepth(load(i), T);
+        if(z > zmax || z < zmin || !visible(i, z)) continue;
+        forPasses<K0, K1>([&](auto k){ if(passContains<decltype(k)::value>(z)) cnt[k]++; });
+    }
+    return cnt;
+}
+
+template<int K0, int K1, class Load, class Visible, class Emit, class Palette>
+void writePassesScalar(int i0, int i1, float T, Load &&load, Visible &&visible, Emit &&emit, const Palette &palette){
+    constexpr float zmax = passesZNear(K0, K1), zmin = passesZFar(K0, K1);
+    for(int i = i0; i < i1; i++){
+        const Particle p = load(i);
+        float z = particleDepth(p, T);
+        // Recorte antes de cualquier cálculo (la partícula no aparece en ningún pase)
+        if(z > zmax || z < zmin || !visible(i, z)) continue;
+
+        const ParticleTerms t = particleTerms(p, z, T, palette);
+        forPasses<K0, K1>([&](auto k){
+            constexpr PassConfig pc = PASSES[decltype(k)::value];
+            if(!passContains<decltype(k)::value>(z)) return;
+            float a = t.a0 + pc.swirl*T;
+            emit(decltype(k)::value, (t.r+t.wob)*cosf(a) + t.jitx, (t.r-t.wob)*sinf(a) + t.jity, z,
+                 t.cr, t.cg, t.cb, t.fade * pc.alphaMul);
+        });
+    }
+}
+
+// Tramo r de los `ranges` en que se parte el trabajo: contiguo (chunk 0, un tramo por hilo) o de chunk unidades
+inline void passRangeBounds(int units, int ranges, int chunk, int r, int &u0, int &u1){
+    if(chunk > 0){
+        u0 = r * chunk;
+        u1 = std::min(units, u0 + chunk);
+    } else {
+        u0 = (int)((long long)units * r / ranges);
+        u1 = (int)((long long)units * (r + 1) / ranges);
+    }
+}
+
+// Suma prefija exclusiva de los conteos por tramo: deja en cada tramo su desplazamiento de salida
+// y en visible el total de vértices visibles por pase
+inline void exclusiveScanPassCounts(std::vector<PassCounts> &range_counts, int ranges, int k0, int k1, int *visible){
+    for(int k = k0; k < k1; k++){
+        int sum = 0;
+        for(int r = 0; r < ranges; r++){
+            int c = range_counts[r][k];
+            range_counts[r][k] = sum;
+            sum += c;
+        }
+        visible[k] = sum;
+    }
+}
+
+// Backends: cómo se ejecutan las fases count(r) para cada tramo, scan() y write(r) para cada tramo.
+// Secuencial: en el hilo que llama, sin región paralela (la versión paralela con un hilo)
+struct SequentialBackend {
+    template<class Count, class Scan, class Write>
+    void run(int ranges, Count &&count, Scan &&scan, Write &&write){
+        for(int r = 0; r < ranges; r++) count(r);
+        scan();
+        for(int r = 0; r < ranges; r++) write(r);
+    }
+};
+
+#ifdef _OPENMP
+// Una región OpenMP: los tramos se reparten con el schedule pedido y la suma prefija la hace un hilo.
+// Los desplazamientos son por tramo, así que el resultado no depende de qué hilo hizo cada uno.
+struct OpenMPBackend {
+    int threads;
+    omp_sched_t kind;
+
+    template<class Count, class Scan, class Write>
+    void run(int ranges, Count &&count, Scan &&scan, Write &&write){
+        omp_set_schedule(kind, 1);
+        #pragma omp parallel num_threads(threads)
+        {
+            {
+                TRACE_SCOPE("pases: conteo (hilo)");
+                #pragma omp for schedule(runtime) nowait
+                for(int r = 0; r < ranges; r++) count(r);
+            }
+
+            #pragma omp barrier
+            #pragma omp single
+            {
+                TRACE_SCOPE("pases: suma prefija");
+                scan();
+            }
+
+            TRACE_SCOPE("pases: escritura (hilo)");
+            #pragma omp for schedule(runtime) nowait
+            for(int r = 0; r < ranges; r++) write(r);
+        }
+    }
+};
+#endif
+
+// Grafo de tareas: una tarea de conteo y una de escritura por tramo, unidas por la suma prefija.
+// Solo arma el grafo (lo ejecuta quien lo armó); write_tasks queda con la escritura de cada tramo
+// para encadenarle subidas o envíos.
+struct TaskBackend {
+    TaskGraph &graph;
+    int scan_task = -1;
+    std::vector<int> write_tasks;
+
+    explicit TaskBackend(TaskGraph &g) : graph(g) {}
+
+    template<class Count, class Scan, class Write>
+    void run(int ranges, Count count, Scan scan, Write write){
+        scan_task = graph.add("pases: suma prefija", scan);
+        write_tasks.resize(ranges);
+        for(int r = 0; r < ranges; r++){
+            int c = graph.add("pases: conteo (tramo)", [count, r]{ count(r); });
+            int w = graph.add("pases: escritura (tramo)", [write, r]{ write(r); });
+            graph.depend(c, scan_task);
+            graph.depend(scan_task, w);
+            write_tasks[r] = w;
+        }
+    }
+};
+
+// Pases [k0,k1) compactos sobre `units` unidades de trabajo partidas en `ranges` tramos:
+// count(u0, u1) cuenta los visibles por pase del tramo y write(u0, u1, pos) los escribe desde pos.
+// range_counts debe vivir hasta que el backend termine (el de tareas solo arma el grafo).
+template<class Backend, class Count, class Write>
+void computeCompactPasses(Backend &backend, int units, int ranges, int chunk, int k0, int k1,
+                          std::vector<PassCounts> &range_counts, int *visible, Count count, Write write){
+    range_counts.assign(ranges, PassCounts{});
+    PassCounts *offsets = range_counts.data();
+    std::vector<PassCounts> *counts = &range_counts;
+    backend.run(ranges,
+        [=](int r){
+            int u0, u1;
+            passRangeBounds(units, ranges, chunk, r, u0, u1);
+            offsets[r] = count(u0, u1);
+        },
+        [=]{ exclusiveScanPassCounts(*counts, ranges, k0, k1, visible); },
+        [=](int r){
+            int u0, u1;
+            passRangeBounds(units, ranges, chunk, r, u0, u1);
+            write(u0, u1, offsets[r]);
+        });
+}
@@ -1,15 +1,53 @@
 // Silencia advertencias deprecadas de OpenGL
 #define GL_SILENCE_DEPRECATION
+// Prototipos de GL > 1.1 (buffers de vértices) en plataformas que los separan en glext.h
+#define GL_GLEXT_PROTOTYPES
+// SCREENSAVER_NO_GL: compilación solo headless (framebuffer de CPU), sin GL ni GLUT
+#ifndef SCREENSAVER_NO_GL
+#ifdef __APPLE__
 #include <OpenGL/gl.h>
 #include <OpenGL/glu.h>
 #include <GLUT/glut.h>
+#else
+#include <GL/gl.h>
+#include <GL/glu.h>
+#include <GL/glut.h>
+#endif
+#else
+typedef unsigned int GLuint;
+#endif
 #include <omp.h>
 #include <vector>
-#include <random>
 #include <chrono>
 #include <cmath>
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include "headless.h"
+#include "simd.h"
+#include "heavy_math.h"
+#include "counter_rng.h"
+#include "particle_cache.h"
+#include "headless_gl.h"
+#include "trace.h"
+#include "latency.h"
+#include "task_graph.h"
+#include "frame_pipeline.h"
+#include "autotune.h"
+#include "numa.h"
+#include "frustum.h"
+#include "tile_raster.h"
+#include "pass_engine.h"
+#include "particle_field.h"
+#include "visibility_index.h"
+#include "palette_lut.h"
+#include "stream_ring.h"
+#include "app_shell.h"
 
 using namespace std;
 
@@ -23,17 +61,64 @@ int STAR_COUNT = 15000;        // Cantidad de estrellas
 int MATH_ITERATIONS = 15;      // Carga matemática por partícula (simula cómputo pesado)
 bool HEAVY_MATH_MODE = true;   // Activa/desactiva la carga pesada  
 int num_threads = 4;           // Cantidad de hilos OpenMP a usar (se puede ajustar en runtime con +/-)   
+bool SIMD_KERNEL = true;       // Kernel vectorizado para los pases (--no-simd usa el kernel escalar)
+bool FUSED_PASSES = true;      // Los 6 pases en un solo barrido paralelo (--no-fuse: un barrido por pase)
+bool VBO_RENDER = true;        // Envío con buffers de vértices y glDrawArrays (--immediate: glBegin/glEnd)
+bool SHADER_RENDER = false;    // Animación en el vertex shader sin pre-cálculo en CPU (--shader o tecla G)
+bool FAST_MATH = true;         // Carga matemática de gen() con funciones SIMD (--libm: sinf/powf/... escalares)
+bool VALIDATE_MATH = false;    // --validate-math: compara la carga SIMD contra libm al generar
+bool TASK_SCHEDULER = false;   // Frame como grafo de tareas con robo de trabajo (--tasks o tecla T)
+int STAR_CHUNK = 2048;         // Estrellas por tarea en modo tareas (--star-chunk N)
+int PASS_CHUNK = 16384;        // Partículas por tarea en modo tareas (--pass-chunk N)
+bool PARTICLE_CACHE = true;    // Guarda/carga el campo generado en CACHE_DIR (--no-cache lo desactiva)
+string CACHE_DIR = "cache_particulas";     // --cache DIR
+int PIPELINE_DEPTH = 0;        // Juegos de buffers del pipeline de frames (--pipeline N, 2 o 3; 0: sin pipeline; tecla P)
+bool AUTOTUNE = false;         // Autoajuste de hilos y schedule por etapa (--autotune o tecla U)
+bool COMPACT_VERTICES = false; // Vértices de 12 bytes: posición int16 y color RGBA8 (--compact o tecla V)
+bool FRUSTUM_CULL = true;      // Recorte por frustum antes del sombreado de los pases (--no-cull; tecla K)
+bool SOFT_RASTER = false;      // Rasterizador de puntos por software en teselas, presentado como textura (--raster; tecla R)
+bool VISIBILITY_INDEX = false; // Salta en bloque las partículas fuera del rango de profundidad de cada pase sin fusionar (--index; tecla I)
+bool PALETTE_LUT = false;      // Color de los pases por tabla bilineal en lugar de colorBH (--palette N; tecla L)
+int PALETTE_RES = 64;          // Puntos por eje de la tabla de paleta (--palette N)
+bool STREAM_PASSES = false;    // Cada pase por tramos en un anillo de buffers, enviados mientras se calculan los siguientes (--stream)
+int STREAM_CHUNK = 8192;       // Partículas por tramo del envío por tramos (--stream-chunk N)
+ThreadAffinity THREAD_AFFINITY = AFFINITY_NONE;    // --affinity compact|spread: fija los hilos OpenMP a CPUs
+bool NUMA_REPORT = false;      // --numa-report: ubicación de hilos y páginas tras generar
 
-// Medición de tiempos
-chrono::high_resolution_clock::time_point start_time;
-chrono::high_resolution_clock::time_point frame_start;
-chrono::high_resolution_clock::time_point frame_end;
-double total_gen_time = 0.0;    // tiempo total de generación por sesión
-double total_draw_time = 0.0;   // tiempo total de dibujo por sesión
-double total_computation_time = 0.0;    // tiempo acumulado por frame (display)
+// Medición de la sesión (frame_session.h): tiempos acumulados de generación, dibujo y frame,
+// latencias por etapa y FPS del HUD; aquí además el tiempo de las secciones paralelas
 double total_parallel_time = 0.0;       // tiempo dedicado a secciones paralelas
-int frame_count_timing = 0;     // #frames medidos
-bool timing_enabled = true;     // habilita/inhabilita medición
+
+// Tiempos por etapa (cálculo paralelo y envío de puntos) acumulados por sesión
+double stars_calc_time = 0.0;
+double stars_draw_time = 0.0;
+double pass_calc_time[6] = {0};
+double pass_draw_time[6] = {0};
+double fused_calc_time = 0.0;   // barrido fusionado de los 6 pases
+double raster_time = 0.0;       // teselas del rasterizador por software (acumulación, resolución y textura)
+double palette_time = 0.0;      // armado y medición de la tabla de paleta del frame
+float palette_max_error = 0.0f; // error máximo medido de la tabla de paleta en la sesión
+
+// Etapas de los histogramas de latencia de la sesión (frame_session.h)
+enum { LAT_FRAME, LAT_STARS_CALC, LAT_STARS_DRAW, LAT_PASS_CALC, LAT_PASS_DRAW, LAT_SWAP, LAT_PIPELINE };
+FrameSession session{"Frame", "Estrellas: cálculo", "Estrellas: envío",
+                     "Pases: cálculo", "Pases: envío", "Swap/glFinish", "Pipeline: cálculo→envío"};
+double pipeline_frame_latency = -1.0;   // del inicio del cálculo del frame a su envío (solo con pipeline)
+float pipeline_t_error = 0.0f;          // T predicho - T real al enviar el frame (solo con pipeline)
+
+// Modo headless: sin ventana, dibuja en un framebuffer de CPU
+HeadlessConfig headless;
+HeadlessFramebuffer headless_fb;
+
+// Rasterizador por software (--raster): en headless sin GL reemplaza a headless_fb
+TileRasterizer soft_raster;
+GLuint raster_texture = 0;
+
+// Nombres de los eventos de traza por pase (cadenas estáticas, ver trace.h)
+const char *PASS_CALC_TRACE[PASS_COUNT] = {"pase 0: cálculo", "pase 1: cálculo", "pase 2: cálculo",
+                                           "pase 3: cálculo", "pase 4: cálculo", "pase 5: cálculo"};
+const char *PASS_SUBMIT_TRACE[PASS_COUNT] = {"pase 0: envío", "pase 1: envío", "pase 2: envío",
+                                             "pase 3: envío", "pase 4: envío", "pase 5: envío"};
 
 // Estructura con datos ya listos para pintar (posición, color, visibilidad)
 struct RenderData {
@@ -42,124 +127,408 @@ struct RenderData {
     bool visible;
 };
 
-// Cámara en modo “orbital” o “libre” (freeMode)
-struct Camera {
-    float x, y, z;          
-    float pitch, yaw;       
-    float speed;            
-    bool freeMode;          
-} camera = {30.0f, 5.0f, 0.0f, 0.0f, 0.0f, 2.0f, false};
+// Formato compacto (--compact o tecla V): posición en punto fijo int16 y color RGBA8, 12 bytes por
+// vértice en vez de 32. Las escalas cubren |x|,|y| < 256 con paso 1/128 y |z| < 8192 con paso 1/4
+// (estrellas incluidas); el color se satura a [0,1] como lo hace GL al rasterizar.
+const float COMPACT_XY_SCALE = 128.0f;
+const float COMPACT_Z_SCALE = 4.0f;
+
+struct CompactVertex {
+    int16_t x, y, z, pad;
+    uint8_t r, g, b, a;
+};
+static_assert(sizeof(CompactVertex) == 12, "CompactVertex debe ocupar 12 bytes");
+
+// Redondeo y saturación con min/max y conversión directa: lrintf, fminf y fmaxf sin -ffast-math
+// son llamadas a libm por componente (más caras que el resto del vértice)
+inline int16_t quantizeFixed(float v, float scale){
+    float q = min(32767.f, max(-32768.f, v * scale));
+    return (int16_t)(q + copysignf(0.5f, q));
+}
+
+inline uint8_t quantizeUnit(float v){
+    return (uint8_t)(min(1.f, max(0.f, v)) * 255.f + 0.5f);
+}
+
+// Versiones vectoriales para el kernel SIMD, con el mismo redondeo que las escalares (empates lejos
+// del cero, no al par como la conversión por defecto): ambos kernels dan los mismos vértices
+inline vint quantizeFixed(vfloat v, float scale){
+    vfloat q = vmin(vfloat(32767.f), vmax(vfloat(-32768.f), v * vfloat(scale)));
+    return vcvtt(q + (vfloat(0.5f) | (q & vfloat(-0.f))));
+}
+
+inline vint quantizeUnit(vfloat v){
+    return vcvtt(vmin(vfloat(1.f), vmax(vfloat(0.f), v)) * vfloat(255.f) + vfloat(0.5f));
+}
+
+// Vértice en cualquiera de los dos formatos (los kernels se instancian para ambos)
+template<class V> V makeVertex(float x, float y, float z, float r, float g, float b, float a);
+
+template<> inline RenderData makeVertex<RenderData>(float x, float y, float z, float r, float g, float b, float a){
+    return {x, y, z, r, g, b, a, true};
+}
+
+template<> inline CompactVertex makeVertex<CompactVertex>(float x, float y, float z, float r, float g, float b, float a){
+    return {quantizeFixed(x, COMPACT_XY_SCALE), quantizeFixed(y, COMPACT_XY_SCALE), quantizeFixed(z, COMPACT_Z_SCALE), 0,
+            quantizeUnit(r), quantizeUnit(g), quantizeUnit(b), quantizeUnit(a)};
+}
+
+// Recorre `count` vértices desde `first` decodificados a float: fn(x, y, z, r, g, b, a)
+template<class F>
+inline void forEachVertex(const void *data, bool compact, size_t first, size_t count, F fn){
+    if(compact){
+        const CompactVertex *v = (const CompactVertex*)data + first;
+        for(size_t i = 0; i < count; i++){
+            fn(v[i].x * (1.f / COMPACT_XY_SCALE), v[i].y * (1.f / COMPACT_XY_SCALE), v[i].z * (1.f / COMPACT_Z_SCALE),
+               v[i].r * (1.f / 255.f), v[i].g * (1.f / 255.f), v[i].b * (1.f / 255.f), v[i].a * (1.f / 255.f));
+        }
+    } else {
+        const RenderData *v = (const RenderData*)data + first;
+        for(size_t i = 0; i < count; i++){
+            if(v[i].visible) fn(v[i].x, v[i].y, v[i].z, v[i].r, v[i].g, v[i].b, v[i].a);
+        }
+    }
+}
+
+// Cámara orbital o libre y estado del mouse (camera.h)
+Camera camera;
+
+// Estrellas (la partícula básica y la tabla de pases están en pass_engine.h)
+vector<Particle> stars;
+
+// Partículas en formato SoA: un arreglo alineado por campo para que los pases se vectoricen.
+// La capacidad se redondea a SIMD_WIDTH; el relleno queda fuera de cualquier rango visible.
+struct ParticleStore {
+    float *a = nullptr, *z = nullptr, *r = nullptr, *spd = nullptr;
+    float *band = nullptr, *jx = nullptr, *jy = nullptr;
+    size_t n = 0;
+    size_t capacity = 0;
+    ParticleCacheMap mapped;        // si los arreglos apuntan a un archivo de caché mapeado
+    
+    size_t size() const { return n; }
+    
+    // Cambia la cantidad conservando las partículas existentes. Solo se reubica al superar la
+    // capacidad (que crece al doble); al reducir se conserva la memoria para volver a crecer.
+    void resize(size_t count){
+        if(count > capacity) reserve(max(count, capacity * 2));
+        n = count;
+        size_t padded = min(capacity, ((n + SIMD_WIDTH - 1) / SIMD_WIDTH) * SIMD_WIDTH);
+        for(size_t i = n; i < padded; i++){
+            a[i] = 0.f; z[i] = 1.0e9f; r[i] = 0.f; spd[i] = 0.f;
+            band[i] = 0.f; jx[i] = 0.f; jy[i] = 0.f;
+        }
+    }
+    
+    void reserve(size_t count){
+        size_t cap = ((count + SIMD_WIDTH - 1) / SIMD_WIDTH) * SIMD_WIDTH;
+        if(cap <= capacity) return;
+        float **fields[] = {&a, &z, &r, &spd, &band, &jx, &jy};
+        for(float **f : fields){
+            // Copia con primer toque paralelo: cada hilo escribe primero su tramo de bloques SIMD
+            float *grown = simdAllocFloats(cap);
+            firstTouchFloats(grown, *f, *f ? n : 0, cap, SIMD_WIDTH, num_threads);
+            if(!mapped.base) free(*f);
+            *f = grown;
+        }
+        particleCacheClose(mapped);
+        capacity = cap;
+    }
+    
+    // Usa directamente los arreglos de un archivo de caché (sin copiar); el relleno ya viene escrito.
+    // Con más de un nodo NUMA las páginas del caché de archivos están donde las leyó el kernel: se
+    // reescriben en paralelo para que la copia privada de cada una quede en el nodo de su hilo.
+    void adopt(ParticleCacheMap &map){
+        release();
+        float **fields[] = {&a, &z, &r, &spd, &band, &jx, &jy};
+        for(int f = 0; f < PARTICLE_CACHE_FIELDS; f++) *fields[f] = map.field(f);
+        n = map.header().key.count;
+        capacity = map.header().capacity;
+        if(numaNodeCount() > 1){
+            for(float **f : fields) firstTouchInPlace(*f, capacity, SIMD_WIDTH, num_threads);
+        }
+        mapped = map;
+        map = ParticleCacheMap();
+    }
+    
+    void release(){
+        float **fields[] = {&a, &z, &r, &spd, &band, &jx, &jy};
+        for(float **f : fields){
+            if(!mapped.base) free(*f);
+            *f = nullptr;
+        }
+        particleCacheClose(mapped);
+        n = capacity = 0;
+    }
+    
+    void set(size_t i, const Particle &p){
+        a[i] = p.a; z[i] = p.z; r[i] = p.r; spd[i] = p.spd;
+        band[i] = p.band; jx[i] = p.jx; jy[i] = p.jy;
+    }
+    
+    ~ParticleStore(){ release(); }
+} pts;
+
+// Buffers de render precomputados (partículas/estrellas), con vértices en el formato activo
+// (vertexBytes() por vértice; la memoria se guarda en palabras de 32 bits). Se reservan sin
+// inicializar y con primer toque paralelo (allocRenderBuffer), para que cada porción quede en el
+// nodo NUMA de quien la escribe.
+// El pase k ocupa los vértices [k*c, k*c + pass_visible_count[k]) de particle_render_data, con c la
+// capacidad del SoA: solo vértices visibles, contiguos, sin usar el campo visible. Así cambiar la
+// cantidad de partículas sin superar la capacidad no reubica el buffer. Con --stream queda vacío
+// (los pases se escriben por tramos en el anillo de streamPass).
+using RenderBuffer = vector<uint32_t, FirstTouchAllocator<uint32_t>>;
+RenderBuffer particle_render_data;
+RenderBuffer star_render_data;
+int pass_visible_count[PASS_COUNT] = {0};
+
+inline size_t passStride(){ return pts.capacity; }
+inline size_t vertexBytes(){ return COMPACT_VERTICES ? sizeof(CompactVertex) : sizeof(RenderData); }
+inline size_t bufferBytes(const RenderBuffer &buffer){ return buffer.size() * sizeof(uint32_t); }
+inline size_t particleBufferSlices(){ return STREAM_PASSES ? 0 : PASS_COUNT; }
+
+// Destino de los pre-cálculos: el VBO mapeado (modo VBO) o los vectores de arriba
+void *particle_out = nullptr;
+void *star_out = nullptr;
+GLuint particle_vbo = 0, star_vbo = 0;
+
+// Recorte por frustum de los pases (--no-cull lo desactiva). Las partículas giran alrededor del eje z
+// con un ángulo que depende del pase, así que se prueba el anillo que puede ocupar cada una. Los
+// grupos son rebanadas de profundidad del túnel (las 7 bandas comparten la misma envolvente radial):
+// cada frame se clasifican con el radio máximo posible en la rebanada y solo las que cortan el borde
+// del volumen prueban partícula por partícula, antes de la trigonometría y de colorBH().
+const int CULL_SLABS = 128;
+const float CULL_Z_NEAR = 1200.f, CULL_Z_FAR = -3000.f;    // rango de profundidad de todos los pases
+
+struct ParticleCull {
+    ViewFrustum frustum;
+    uint8_t slab[CULL_SLABS];       // CullClass de cada rebanada
+    int open[CULL_SLABS + 1];       // rebanadas no descartadas antes de cada una (para el índice de visibilidad)
+};
+
+ParticleCull frame_cull;
+float cull_r_max = 0.f;             // máximo |r| del campo (radio base antes del ensanche con z)
+float cull_jitter_max = 0.f;        // máximo |(jx, jy)| del campo
+
+// Índice de visibilidad (visibility_index.h): copia del SoA ordenada por cubetas de velocidad y
+// profundidad inicial. Se arma al generar o cambiar la cantidad de partículas; pts sigue siendo el
+// campo canónico (caché, huella, cambios de cantidad).
+VisibilityIndex visibility_index;
+atomic<long long> index_blocks_visited{0}, index_blocks_total{0};  // bloques recorridos / del campo, acumulados
+
+// Solo con un barrido por pase (--no-fuse o --stream): los 6 pases fusionados cubren todo el túnel y
+// no hay cubetas que saltar. El orden de las partículas cambia, y con él el de dibujo dentro del pase.
+inline bool visibilityIndexActive(){
+    return VISIBILITY_INDEX && (!FUSED_PASSES || STREAM_PASSES) && visibility_index.built() && visibility_index.size() == pts.size();
+}
+
+// Tabla de paleta del frame normal (palette_lut.h); cada juego del pipeline arma la suya con su T
+PaletteLUT frame_palette;
+
+// Lo que un pre-cálculo necesita del frame: instante de la animación, salidas y conteo de visibles
+// por pase. El frame normal usa T y los destinos de arriba; el pipeline, los de su juego de buffers.
+struct FrameTarget {
+    float t;
+    void *particles;
+    size_t stride;                  // vértices entre el inicio de dos pases en particles
+    void *stars;
+    int *visible;
+    bool compact;                   // formato de los vértices de salida
+    const ParticleCull *cull;       // recorte de la cámara del frame (nullptr: sin recorte)
+    ParticleArrays src;             // SoA que leen los kernels: pts o la copia del índice
+    const VisibilityIndex *index;   // índice para saltar cubetas (nullptr: se recorre todo pts)
+    const PaletteLUT *palette;      // tabla de paleta del instante t (nullptr: colorBH exacto)
+};
+
+// Destino de un frame; las partículas se leen del índice si está activo y al día con pts
+inline FrameTarget frameTarget(float t, void *particles, void *stars, int *visible, bool compact, const ParticleCull *cull,
+                               const PaletteLUT *palette){
+    const bool indexed = visibilityIndexActive();
+    return {t, particles, passStride(), stars, visible, compact, cull,
+            indexed ? visibility_index.arrays() : ParticleArrays{pts.a, pts.z, pts.r, pts.spd, pts.band, pts.jx, pts.jy},
+            indexed ? &visibility_index : nullptr, palette};
+}
+
+inline FrameTarget currentFrameTarget(){
+    return frameTarget(T, particle_out, star_out, pass_visible_count, COMPACT_VERTICES, FRUSTUM_CULL ? &frame_cull : nullptr,
+                       PALETTE_LUT ? &frame_palette : nullptr);
+}
+
+// Autoajuste (--autotune): un StageTuner por región paralela del frame. Sin autoajuste todas usan
+// num_threads con el reparto estático por hilo. El modo tareas no se ajusta (usa sus propios tramos).
+enum { TUNE_STARS, TUNE_PASSES, TUNE_PASS0 };      // TUNE_PASS0 + k: pase k sin fusionar
+const int TUNE_STAGES = TUNE_PASS0 + PASS_COUNT;
+const char *TUNE_NAMES[TUNE_STAGES] = {"estrellas", "pases fusionados", "pase 0", "pase 1", "pase 2",
+                                       "pase 3", "pase 4", "pase 5"};
+StageTuner stage_tuners[TUNE_STAGES];
 
-int lastMouseX = W/2, lastMouseY = H/2;
-bool mousePressed = false;
+StageConfig stageConfig(int stage){
+    if(AUTOTUNE) return stage_tuners[stage].current();
+    StageConfig cfg;
+    cfg.threads = num_threads;
+    return cfg;
+}
 
-// HUD: FPS y contadores
-bool showFPS = true;
-int frameCount = 0;
-float lastTime = 0.0f;
-float currentFPS = 0.0f;
+void stageMeasured(int stage, const StageConfig &cfg, double seconds){
+    if(AUTOTUNE) stage_tuners[stage].record(cfg, seconds);
+}
 
-// Partícula básica y contenedores
-struct Particle{float a,z,r,spd,band,jx,jy;};
-vector<Particle> pts,stars;
+// (Re)inicia la búsqueda de todas las etapas. Chunks en estrellas y en unidades del kernel de pases.
+void autotuneRestart(){
+    const int max_threads = omp_get_max_threads();
+    stage_tuners[TUNE_STARS].init(TUNE_NAMES[TUNE_STARS], max_threads, {128, 512, 2048});
+    for(int s = TUNE_PASSES; s < TUNE_STAGES; s++) stage_tuners[s].init(TUNE_NAMES[s], max_threads, {256, 1024, 4096});
+}
 
-// Buffers de render precomputados (partículas/estrellas)
-vector<RenderData> particle_render_data;
-vector<RenderData> star_render_data;
+// Reinicia los acumuladores por frame (al terminar el calentamiento del modo headless)
+void resetFrameTimers(){
+    session.resetFrames();
+    total_parallel_time = 0.0;
+    stars_calc_time = stars_draw_time = fused_calc_time = raster_time = palette_time = 0.0;
+    palette_max_error = 0.0f;
+    for(int k = 0; k < PASS_COUNT; k++) pass_calc_time[k] = pass_draw_time[k] = 0.0;
+    index_blocks_visited = index_blocks_total = 0;
+}
 
-// Tiempo relativo desde que inició el programa
-float now(){ 
-    static auto t0=chrono::high_resolution_clock::now(); 
-    auto t=chrono::high_resolution_clock::now(); 
-    return chrono::duration<float>(t-t0).count(); 
+// Suma de los acumuladores por etapa; la diferencia entre el inicio y el fin de un frame
+// da el tiempo de cada etapa en ese frame
+array<double, 4> stageTotals(){
+    array<double, 4> t = {stars_calc_time, stars_draw_time, fused_calc_time, 0.0};
+    for(int k = 0; k < PASS_COUNT; k++){
+        t[2] += pass_calc_time[k];
+        t[3] += pass_draw_time[k];
+    }
+    return t;
 }
 
 // Escritura de métricas a archivo
 void saveTimingMetrics() {
-    if (frame_count_timing > 0) {
-        ofstream file("parallel_timing_results.txt", ios::app);
-        file << "=== MÉTRICAS PARALELAS (OpenMP - ALTA CARGA) ===" << endl;
-        file << "Número de hilos utilizados: " << num_threads << endl;
-        file << "Partículas procesadas: " << PARTICLE_COUNT << endl;
-        file << "Iteraciones matemáticas por partícula: " << MATH_ITERATIONS << endl;
-        file << "Estrellas: " << STAR_COUNT << endl;
-        file << "Frames procesados: " << frame_count_timing << endl;
-        file << "Tiempo de generación por frame: " << (total_gen_time / frame_count_timing) * 1000 << " ms" << endl;
-        file << "Tiempo de renderizado por frame: " << (total_draw_time / frame_count_timing) * 1000 << " ms" << endl;
-        file << "Tiempo de cálculos paralelos por frame: " << (total_parallel_time / frame_count_timing) * 1000 << " ms" << endl;
-        file << "Tiempo total de computación: " << total_computation_time << " segundos" << endl;
-        file << "Tiempo por frame: " << (total_computation_time / frame_count_timing) * 1000 << " ms" << endl;
-        file << "FPS basado en cálculos: " << frame_count_timing / total_computation_time << endl;
-        file << "Operaciones matemáticas estimadas por frame: " << (PARTICLE_COUNT * MATH_ITERATIONS * 10) << endl;
-        file << "=====================================" << endl << endl;
-        file.close();
-        
-        // Resumen en consola
-        cout << "\n=== MÉTRICAS PARALELAS FINALES ===" << endl;
-        cout << "Número de hilos: " << num_threads << endl;
-        cout << "Partículas: " << PARTICLE_COUNT << " | Iteraciones: " << MATH_ITERATIONS << endl;
-        cout << "Frames procesados: " << frame_count_timing << endl;
-        cout << "Tiempo total de computación: " << total_computation_time << " segundos" << endl;
-        cout << "Tiempo por frame: " << (total_computation_time / frame_count_timing) * 1000 << " ms" << endl;
-        cout << "FPS: " << frame_count_timing / total_computation_time << endl;
-        cout << "====================================" << endl;
-    }
+    session.saveMetrics({"parallel_timing_results.txt", "=== MÉTRICAS PARALELAS (OpenMP - ALTA CARGA) ===", "=== MÉTRICAS PARALELAS FINALES ==="},
+                        PARTICLE_COUNT, MATH_ITERATIONS, STAR_COUNT,
+        [](ostream &out){ out << "Número de hilos utilizados: " << num_threads << endl; },
+        [](ostream &out){
+            out << "Tiempo de cálculos paralelos por frame: " << (total_parallel_time / session.frame_count_timing) * 1000 << " ms" << endl;
+        });
 }
 
-// Generación paralela de datos
-void gen(int n = -1){
-    if(n == -1) n = PARTICLE_COUNT;
+// Huella de los datos generados: igual en la versión secuencial y la paralela con cualquier número de hilos
+uint64_t dataFingerprint(){
+    return fieldFingerprint(pts.size(), [](size_t i){
+        return Particle{pts.a[i], pts.z[i], pts.r[i], pts.spd[i], pts.band[i], pts.jx[i], pts.jy[i]};
+    }, stars);
+}
+
+// Reserva un buffer de render de `slices` porciones (una por pase) de `stride` vértices en el
+// formato activo, sin inicializar, y le da el primer toque en paralelo: cada hilo su parte de cada porción
+void allocRenderBuffer(RenderBuffer &buffer, size_t stride, size_t slices){
+    const size_t slice_bytes = stride * vertexBytes();
+    RenderBuffer((slice_bytes * slices + sizeof(uint32_t) - 1) / sizeof(uint32_t)).swap(buffer);
+    firstTouchSlices((uint8_t*)buffer.data(), slices, slice_bytes, num_threads);
+}
+
+// Páginas por nodo de un conjunto de arreglos y cuántas están en el nodo del hilo que procesa su
+// primer elemento según la partición estática
+struct NumaPlacement {
+    vector<size_t> per_node;
+    size_t absent = 0, local = 0;
+    bool available = true;
     
-    auto gen_start = chrono::high_resolution_clock::now();
+    // owner(i): hilo que procesa el elemento i
+    template<class Owner>
+    void add(const void *base, size_t count, size_t elem_bytes, const vector<int> &thread_node, Owner owner){
+        vector<int> nodes;
+        if(!numaPageNodes(base, count * elem_bytes, nodes)){
+            available = false;
+            return;
+        }
+        const uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE), start = (uintptr_t)base;
+        for(size_t p = 0; p < nodes.size(); p++){
+            if(nodes[p] < 0){
+                absent++;
+                continue;
+            }
+            if(nodes[p] >= (int)per_node.size()) per_node.resize(nodes[p] + 1, 0);
+            per_node[nodes[p]]++;
+            uintptr_t page_start = (start / page + p) * page;
+            size_t i = page_start <= start ? 0 : min(count - 1, (size_t)((page_start - start) / elem_bytes));
+            if(nodes[p] == thread_node[owner(i)]) local++;
+        }
+    }
     
-    cout << "Generando " << n << " partículas PARALELO" << endl;
+    void print(const char *name) const {
+        if(!available){
+            printf("   • %s: ubicación de páginas no disponible (move_pages)\n", name);
+            return;
+        }
+        size_t present = 0;
+        printf("   • %s: páginas por nodo [", name);
+        for(size_t n = 0; n < per_node.size(); n++){
+            printf("%s%zu: %zu", n ? ", " : "", n, per_node[n]);
+            present += per_node[n];
+        }
+        printf("] sin tocar: %zu | en el nodo de su hilo: %.1f%%\n", absent, present ? 100.0 * local / present : 0.0);
+    }
+};
+
+// Reporte de ubicación (--numa-report): CPU y nodo de cada hilo y páginas de cada buffer
+void printNumaReport(){
+    vector<int> thread_cpu(num_threads, 0), thread_node(num_threads, 0);
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int t = omp_get_thread_num();
+        currentCpuNode(thread_cpu[t], thread_node[t]);
+    }
+    const int nth = num_threads;
+    cout << "Ubicación NUMA: " << numaNodeCount() << " nodo(s), hilos " << affinityName(THREAD_AFFINITY) << endl;
+    for(int t = 0; t < nth; t++) printf("   • Hilo %d: CPU %d, nodo %d\n", t, thread_cpu[t], thread_node[t]);
     
-    // Reserva de espacio: partículas y buffers de render (6 pases)
-    pts.resize(n);
-    particle_render_data.resize(n * 6); 
+    // Dueño de cada elemento: partición estática de los kernels (bloques SIMD o partículas)
+    const size_t block = SIMD_KERNEL ? SIMD_WIDTH : 1;
+    const size_t units = (pts.size() + block - 1) / block;
+    auto unit_owner = [nth](size_t units, size_t u){
+        int t = (int)min<size_t>(nth - 1, u * nth / max<size_t>(1, units));
+        while(t > 0 && units * t / nth > u) t--;
+        while(t + 1 < nth && units * (t + 1) / nth <= u) t++;
+        return t;
+    };
+    NumaPlacement soa;
+    for(const float *f : {pts.a, pts.z, pts.r, pts.spd, pts.band, pts.jx, pts.jy}){
+        soa.add(f, pts.size(), sizeof(float), thread_node, [&](size_t i){ return unit_owner(units, i / block); });
+    }
+    soa.print("Partículas (SoA)");
     
+    if(particle_render_data.empty()) return;
+    NumaPlacement render;
+    const size_t stride = passStride();
+    render.add(particle_render_data.data(), stride * PASS_COUNT, vertexBytes(), thread_node,
+               [&](size_t i){ return unit_owner(stride, i % stride); });
+    render.print("Buffer de render");
+}
+
+// Paso de los cambios de cantidad de partículas (teclas [ ] y --ramp; límites en particle_field.h)
+int PARTICLE_STEP = 50000;      // --particle-step N
+
+// Genera las partículas [i0, i1) del SoA ya dimensionado. Cada partícula depende solo de su
+// índice, así que generar por tramos da los mismos datos que generar todo de una vez.
+// Si se valida, devuelve en a0/jx0 los valores previos a la carga SIMD.
+void generateParticles(int i0, int i1, vector<float> &a0, vector<float> &jx0){
     // Región paralela: inicialización de partículas
     #pragma omp parallel num_threads(num_threads)
     {
-        // RNG por hilo para evitar contención y mantener independencia
-        thread_local std::mt19937 rng(1337 + omp_get_thread_num());
-        thread_local std::uniform_real_distribution<float> U(0.f,1.f);
-        thread_local std::uniform_real_distribution<float> S(-1.f,1.f);
-        
-        // Distribución del trabajo por bloques dinámicos
-        #pragma omp for schedule(dynamic, 100)
-        for(int i = 0; i < n; i++){
-            // Parámetros iniciales de cada partícula
-            pts[i].a=6.2831853f*U(rng);
-            pts[i].z=-1200.f*U(rng)-40.f;
-            pts[i].r=4.f+26.f*powf(U(rng),0.7f);
-            pts[i].spd=18.f+48.f*U(rng);
-            pts[i].band=floorf(U(rng)*7.f);
-            pts[i].jx=0.6f*S(rng);
-            pts[i].jy=0.6f*S(rng);
-            
-            // Carga matemática para simular cómputo intensivo
-            if(HEAVY_MATH_MODE) {
-                for(int iter = 0; iter < MATH_ITERATIONS; iter++) {
-                    float complexity_factor = 1.0f + iter * 0.1f;
-                    float dummy = 0;
-                    
-                    dummy += sinf(pts[i].a * complexity_factor) * cosf(pts[i].z * complexity_factor);
-                    dummy += tanf(pts[i].r * 0.01f + iter) * sinf(pts[i].spd * 0.001f);
-                    dummy += sqrtf(fabsf(pts[i].r * complexity_factor + 1));
-                    dummy += powf(fabsf(pts[i].spd), 1.2f + 0.05f * iter);
-                    dummy += expf(-fabsf(pts[i].jx) * 0.1f) * logf(fabsf(pts[i].jy) + 1.0f);
-                    dummy += atanf(pts[i].band + iter) * sinhf(pts[i].a * 0.1f);
-                    
-                    // Pequeño bucle extra para variar la carga
-                    for(int j = 0; j < 3; j++) {
-                        dummy += cosf(pts[i].a + j) * sinf(pts[i].z + j);
-                    }
-                    
-                    // Perturbación leve de parámetros (no afecta estética)
-                    pts[i].a += dummy * 0.0001f;
-                    pts[i].jx += dummy * 0.00005f;
+        // Distribución del trabajo por bloques dinámicos (nowait: la espera queda fuera del evento)
+        {
+            TRACE_SCOPE("gen: partículas (hilo)");
+            #pragma omp for schedule(dynamic, 100) nowait
+            for(int i = i0; i < i1; i++){
+                // Parámetros iniciales de cada partícula: función de su índice (particle_field.h),
+                // independiente del hilo que la procese (mismos datos que la versión secuencial)
+                Particle p = initialParticle(i);
+                
+                // Carga matemática para simular cómputo intensivo (referencia libm)
+                if(HEAVY_MATH_MODE && !FAST_MATH) {
+                    heavyMathScalar(p.a, p.jx, p.z, p.r, p.spd, p.band, p.jy, MATH_ITERATIONS);
                 }
+                
+                pts.set(i, p);
             }
         }
         
@@ -170,419 +539,1718 @@ void gen(int n = -1){
         }
     }
     
-    // Generación de estrellas (paralela también)
+    // Carga matemática vectorial sobre el SoA ya generado (copias iniciales solo si se valida)
+    if(HEAVY_MATH_MODE && FAST_MATH) {
+        if(VALIDATE_MATH) {
+            a0.assign(pts.a + i0, pts.a + i1);
+            jx0.assign(pts.jx + i0, pts.jx + i1);
+        }
+        TRACE_SCOPE("gen: carga SIMD");
+        int blocks = (i1 - i0 + SIMD_WIDTH - 1) / SIMD_WIDTH;
+        #pragma omp parallel for num_threads(num_threads) schedule(dynamic, 16)
+        for(int blk = 0; blk < blocks; blk++){
+            int j = i0 + blk * SIMD_WIDTH;
+            heavyMathBlock(pts.a + j, pts.jx + j, pts.z + j, pts.r + j, pts.spd + j, pts.band + j, pts.jy + j,
+                           min(SIMD_WIDTH, i1 - j), MATH_ITERATIONS);
+        }
+    }
+}
+
+// Compara contra libm las partículas [i0, i0 + a0.size()) (fuera del tiempo medido)
+void validateParticles(int i0, const vector<float> &a0, const vector<float> &jx0){
+    if(a0.empty()) return;
+    const int count = (int)a0.size();
+    HeavyMathCheck total;
+    #pragma omp parallel num_threads(num_threads)
+    {
+        HeavyMathCheck local;
+        #pragma omp for schedule(static)
+        for(int k = 0; k < count; k++){
+            int i = i0 + k;
+            local.check(a0[k], jx0[k], pts.z[i], pts.r[i], pts.spd[i], pts.band[i], pts.jy[i],
+                        MATH_ITERATIONS, pts.a[i], pts.jx[i]);
+        }
+        #pragma omp critical
+        total.merge(local);
+    }
+    total.print();
+}
+
+// Generación de estrellas (paralela también)
+void generateStars(){
     int m = STAR_COUNT;
     stars.resize(m);
-    star_render_data.resize(m);
     
     #pragma omp parallel num_threads(num_threads)
     {
-        thread_local std::mt19937 rng(2674 + omp_get_thread_num());
-        thread_local std::uniform_real_distribution<float> U(0.f,1.f);
-        
         #pragma omp for schedule(static)
-        for(int i=0; i<m; i++){
-            float a=6.2831853f*U(rng);
-            float R=140.f*sqrtf(U(rng));
-            stars[i]={a,-4000.f*U(rng)-200.f,R*cosf(a),10.f+R*sinf(a),14.f+20.f*U(rng),0.f,0.f};
-            
-            
-            if(HEAVY_MATH_MODE) {
-                for(int iter = 0; iter < 5; iter++) {
-                    float dummy = sinf(a * iter) + cosf(R * iter) + tanf(stars[i].spd * 0.01f);
-                    stars[i].a += dummy * 0.0001f;
-                }
-            }
-        }
+        for(int i=0; i<m; i++) stars[i] = initialStar(i, HEAVY_MATH_MODE);
     }
-    
-    // Fin y acumulación del tiempo de generación
-    auto gen_end = chrono::high_resolution_clock::now();
-    double gen_time = chrono::duration<double>(gen_end - gen_start).count();
-    
-    if (timing_enabled) {
-        total_gen_time += gen_time;
+}
+
+// Cotas del campo para el recorte por rebanadas (tras generar o cambiar la cantidad de partículas)
+void updateCullBounds(){
+    const int n = (int)pts.size();
+    float r_max = 0.f, jitter_max = 0.f;
+    #pragma omp parallel for num_threads(num_threads) reduction(max:r_max, jitter_max)
+    for(int i = 0; i < n; i++){
+        r_max = max(r_max, fabsf(pts.r[i]));
+        jitter_max = max(jitter_max, sqrtf(pts.jx[i]*pts.jx[i] + pts.jy[i]*pts.jy[i]));
     }
-    
-    cout << "Generación PARALELA completada en " << gen_time << " segundos" << endl;
-    cout << "   • Hilos utilizados: " << num_threads << endl;
-    cout << "   • Partículas: " << n << " con " << MATH_ITERATIONS << " iteraciones cada una" << endl;
-    cout << "   • Estrellas: " << m << endl;
-    cout << "   • Operaciones matemáticas: ~" << (n * MATH_ITERATIONS * 10) << " por frame" << endl;
-    cout << endl;
+    cull_r_max = r_max;
+    cull_jitter_max = jitter_max;
 }
 
-// Proyección y cámara
-void proj(){
-    glViewport(0,0,W,H);
-    glMatrixMode(GL_PROJECTION); glLoadIdentity();
-    gluPerspective(72.0,(double)W/(double)H,0.1,6000.0);
-    glMatrixMode(GL_MODELVIEW);
+// Arma el índice de visibilidad sobre el campo actual de pts (sin índice, o con los pases
+// fusionados que no lo usan, se libera la copia)
+void buildVisibilityIndex(){
+    if(!VISIBILITY_INDEX || (FUSED_PASSES && !STREAM_PASSES)){
+        visibility_index.release();
+        return;
+    }
+    TRACE_SCOPE("gen: índice de visibilidad");
+    visibility_index.build({pts.a, pts.z, pts.r, pts.spd, pts.band, pts.jx, pts.jy}, pts.size(), num_threads);
 }
 
-// Cámara orbital por defecto o cámara libre (WASD/QE + mouse)
-void camera_control(){
+#ifndef SCREENSAVER_NO_GL
+void uploadShaderAttributes(size_t first = 0);
+#endif
+void pipelineStop();
+inline bool pipelineActive();
+
+// Cambia el formato de los vértices en caliente (tecla V): los buffers se reubican con el tamaño nuevo
+void setCompactVertices(bool compact){
+    if(compact == COMPACT_VERTICES) return;
+    pipelineStop();     // los juegos del pipeline tienen el formato anterior
+    COMPACT_VERTICES = compact;
+    allocRenderBuffer(particle_render_data, passStride(), particleBufferSlices());
+    allocRenderBuffer(star_render_data, stars.size(), 1);
+    printf("Vértices: %s (%zu bytes), buffers de render %.1f MB\n", compact ? "compactos int16 + RGBA8" : "float completos", vertexBytes(),
+           (bufferBytes(particle_render_data) + bufferBytes(star_render_data)) / 1048576.0);
+}
+
+// Proyección*vista de cameraProjection() + Camera::apply() en el instante t, calculada en CPU para el recorte
+void cameraViewProjection(float t, float *mvp){
+    float P[16], V[16];
+    mat4Perspective(72.0f, (float)W / (float)H, 0.1f, 6000.0f, P);
     if (!camera.freeMode) {
-        float r=28.f+7.f*sinf(0.32f*T);
-        float a=0.3f*T;
-        float h=3.8f+2.8f*sinf(0.21f*T+0.9f);
-        gluLookAt(r*cosf(a),h,r*sinf(a),0,0,-260,0,1,0);
+        float r=28.f+7.f*sinf(0.32f*t);
+        float a=0.3f*t;
+        float h=3.8f+2.8f*sinf(0.21f*t+0.9f);
+        mat4LookAt(r*cosf(a), h, r*sinf(a), 0, 0, -260, 0, 1, 0, V);
     } else {
-        glLoadIdentity();
-        glRotatef(camera.pitch, 1.0f, 0.0f, 0.0f);
-        glRotatef(camera.yaw, 0.0f, 1.0f, 0.0f);
-        glTranslatef(-camera.x, -camera.y, -camera.z);
+        mat4FreeLook(camera.pitch, camera.yaw, camera.x, camera.y, camera.z, V);
+    }
+    mat4Mul(P, V, mvp);
+}
+
+// Clasifica las rebanadas del túnel para la cámara en el instante t. El volumen se agranda ~8 píxeles
+// por lado: GL descarta los puntos por su centro, pero los pases más gruesos miden hasta 4.2 píxeles.
+void buildParticleCull(float t, ParticleCull &c){
+    const float INNER_R = 10.0f;
+    float mvp[16];
+    cameraViewProjection(t, mvp);
+    c.frustum.fromMatrix(mvp, 1.f + 16.f / (float)min(W, H));
+    
+    const float slab_depth = (CULL_Z_NEAR - CULL_Z_FAR) / CULL_SLABS;
+    for(int i = 0; i < CULL_SLABS; i++){
+        float z0 = CULL_Z_FAR + i * slab_depth, z1 = z0 + slab_depth;
+        // Radio máximo en la rebanada: r*(1 + 0.0011 z) es lineal en z, más oscilación y jitter
+        float growth = fmaxf(fabsf(1.f + 0.0011f*z0), fabsf(1.f + 0.0011f*z1));
+        float R = fmaxf(cull_r_max * growth, INNER_R) + 0.8f + cull_jitter_max;
+        c.slab[i] = c.frustum.classifyCylinder(z0, z1, R);
     }
+    c.open[0] = 0;
+    for(int i = 0; i < CULL_SLABS; i++) c.open[i + 1] = c.open[i] + (c.slab[i] != CULL_OUT);
+}
+
+// Rebanada de la profundidad z (las de fuera del rango de los pases se pegan a los extremos)
+inline int cullSlab(float z){
+    return (int)min(max((z - CULL_Z_FAR) * (CULL_SLABS / (CULL_Z_NEAR - CULL_Z_FAR)), 0.f), (float)(CULL_SLABS - 1));
 }
 
-// Colores de partículas (paleta animada)
-void colorBH(float u, float v, float &r, float &g, float &b, float time_T){
-    float c1=0.5f+0.5f*sinf(6.2831853f*(u+0.05f*time_T));
-    float c2=0.5f+0.5f*sinf(6.2831853f*(u*0.5f+0.3f*v)+2.1f+0.1f*time_T);
-    float c3=0.5f+0.5f*sinf(6.2831853f*(u*0.9f-0.2f*v)+3.6f-0.07f*time_T);
-    float blue = 0.55f+0.45f*c1;
-    float purple = 0.45f+0.55f*c2;
-    float pink = 0.55f+0.45f*c3;
-    r = 0.25f*blue + 0.35f*purple + 0.80f*pink;
-    g = 0.35f*blue + 0.45f*purple + 0.30f*pink;
-    b = 1.00f*blue + 0.60f*purple + 0.20f*pink;
+// Alguna rebanada que toca las profundidades [lo, hi] no quedó descartada
+inline bool cullDepthVisible(const ParticleCull &c, float lo, float hi){
+    return c.open[cullSlab(hi) + 1] - c.open[cullSlab(lo)] > 0;
+}
+
+// Anillo que puede ocupar la partícula i a la profundidad z en cualquier pase: radio del pase (con
+// el mínimo INNER_R), oscilación de hasta 0.8 y jitter de hasta |(jx, jy)|
+inline bool cullParticle(const ParticleCull &c, const ParticleArrays &p, int i, float z){
+    const float INNER_R = 10.0f;
+    uint8_t cls = c.slab[cullSlab(z)];
+    if(cls != CULL_PARTIAL) return cls == CULL_IN;
+    float R = max(p.r[i]*(1.f + 0.0011f*z), INNER_R) + 0.8f + sqrtf(p.jx[i]*p.jx[i] + p.jy[i]*p.jy[i]);
+    return c.frustum.ringVisible(z, R);
+}
+
+// Igual para el bloque de SIMD_WIDTH partículas desde i0: bit l = la partícula i0+l puede verse
+inline int cullLanesSIMD(const ParticleCull &c, const ParticleArrays &p, vfloat z, int i0){
+    const float INNER_R = 10.0f;
+    alignas(SIMD_ALIGN) int32_t slab[SIMD_WIDTH];
+    vfloat s = (z - vfloat(CULL_Z_FAR)) * vfloat(CULL_SLABS / (CULL_Z_NEAR - CULL_Z_FAR));
+    vstore(slab, vcvtt(vmin(vmax(s, vfloat(0.f)), vfloat((float)(CULL_SLABS - 1)))));
+    int visible = 0, partial = 0;
+    for(int l = 0; l < SIMD_WIDTH; l++){
+        uint8_t cls = c.slab[slab[l]];
+        if(cls == CULL_IN) visible |= 1 << l;
+        else if(cls == CULL_PARTIAL) partial |= 1 << l;
+    }
+    if(partial){
+        vfloat jx = vload(p.jx + i0), jy = vload(p.jy + i0);
+        vfloat R = vmax(vload(p.r + i0)*(vfloat(1.f) + vfloat(0.0011f)*z), vfloat(INNER_R)) + vfloat(0.8f) + vsqrt(jx*jx + jy*jy);
+        visible |= vmovemask(c.frustum.ringVisible(z, R)) & partial;
+    }
+    return visible;
+}
+
+// Headless sin GL: los puntos van al framebuffer de CPU
+inline bool cpuFramebuffer(){ return headless.enabled && !headless.gl; }
+
+// Modo VBO activo (requiere contexto GL: ventana o headless --gl)
+inline bool vboActive(){ return VBO_RENDER && !cpuFramebuffer() && !SOFT_RASTER; }
+
+#ifndef SCREENSAVER_NO_GL
+// Crea los buffers de vértices (una vez, con el contexto GL ya creado)
+void initVBOs(){
+    glGenBuffers(1, &particle_vbo);
+    glGenBuffers(1, &star_vbo);
+}
+
+// Elige dónde escriben los hilos: en modo VBO se deja huérfano el buffer (el driver entrega
+// memoria nueva sin esperar a los draws del frame anterior) y se mapea para escribir directo.
+// Si el mapeo falla se escribe en el vector y endVertexOutput lo sube con glBufferData.
+void* beginVertexOutput(GLuint vbo, RenderBuffer &fallback){
+    if(!vboActive()) return fallback.data();
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, bufferBytes(fallback), NULL, GL_STREAM_DRAW);
+    void *mapped = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return mapped ? mapped : fallback.data();
+}
+
+// Cierra la escritura: desmapea el VBO o sube los primeros `used` vértices del vector
+void endVertexOutput(GLuint vbo, void *out, RenderBuffer &fallback, size_t used){
+    if(!vboActive()) return;
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if(out == fallback.data()) glBufferSubData(GL_ARRAY_BUFFER, 0, used * vertexBytes(), fallback.data());
+    else glUnmapBuffer(GL_ARRAY_BUFFER);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Dibuja `count` puntos del VBO desde `first` con un solo glDrawArrays (posición y color intercalados).
+// En formato compacto GL convierte los int16 y el RGBA8 (normalizado) a float y la escala del punto
+// fijo se deshace en la matriz de modelo-vista.
+void drawVBO(GLuint vbo, int first, int count){
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    if(COMPACT_VERTICES){
+        glPushMatrix();
+        glScalef(1.f / COMPACT_XY_SCALE, 1.f / COMPACT_XY_SCALE, 1.f / COMPACT_Z_SCALE);
+        glVertexPointer(3, GL_SHORT, sizeof(CompactVertex), (const void*)offsetof(CompactVertex, x));
+        glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(CompactVertex), (const void*)offsetof(CompactVertex, r));
+    } else {
+        glVertexPointer(3, GL_FLOAT, sizeof(RenderData), (const void*)offsetof(RenderData, x));
+        glColorPointer(4, GL_FLOAT, sizeof(RenderData), (const void*)offsetof(RenderData, r));
+    }
+    glDrawArrays(GL_POINTS, first, count);
+    if(COMPACT_VERTICES) glPopMatrix();
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Modo tareas: el buffer se deja huérfano al inicio del frame y cada tramo se sube al terminar
+void orphanVertexBuffer(GLuint vbo, size_t bytes){
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Sube los vértices [first, first+count) en el formato activo
+void uploadVertices(GLuint vbo, const void *data, size_t first, size_t count){
+    if(count == 0) return;
+    const size_t vb = vertexBytes();
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, first * vb, count * vb, (const uint8_t*)data + first * vb);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+#else
+// Sin GL los pre-cálculos siempre escriben en los vectores de CPU
+void* beginVertexOutput(GLuint, RenderBuffer &fallback){ return fallback.data(); }
+void endVertexOutput(GLuint, void*, RenderBuffer&, size_t){}
+#endif
+
+// Brillo titilante de la estrella i
+template<class V>
+inline void computeStarAs(int i, const FrameTarget &ft){
+    const auto &s = stars[i];
+    float tw=0.65f+0.35f*sinf(0.6f*ft.t+s.a*3.f);
+    
+    ((V*)ft.stars)[i] = makeVertex<V>(s.r, s.spd, s.z, 0.45f*tw, 0.55f*tw, 1.0f*tw, 1.0f);
+}
+
+inline void computeStar(int i, const FrameTarget &ft){
+    if(ft.compact) computeStarAs<CompactVertex>(i, ft);
+    else computeStarAs<RenderData>(i, ft);
+}
+
+void preCalculateStarsOMP(const FrameTarget &ft, const StageConfig &cfg){
+    omp_set_schedule(cfg.kind, cfg.chunk);
+    #pragma omp parallel for num_threads(cfg.threads) schedule(runtime)
+    for(int i = 0; i < (int)stars.size(); i++){
+        computeStar(i, ft);
+    }
 }
 
 // Pre-cálculos paralelos de estrellas
 void preCalculateStars(){
+    TRACE_SCOPE("estrellas: cálculo");
     auto calc_start = chrono::high_resolution_clock::now();
     
-    #pragma omp parallel for num_threads(num_threads) schedule(static)
-    for(int i = 0; i < (int)stars.size(); i++){
-        auto &s = stars[i];
-        float tw=0.65f+0.35f*sinf(0.6f*T+s.a*3.f);
-        
-        star_render_data[i].x = s.r;
-        star_render_data[i].y = s.spd;
-        star_render_data[i].z = s.z;
-        star_render_data[i].r = 0.45f*tw;
-        star_render_data[i].g = 0.55f*tw;
-        star_render_data[i].b = 1.0f*tw;
-        star_render_data[i].a = 1.0f;
-        star_render_data[i].visible = true;
-    }
+    star_out = beginVertexOutput(star_vbo, star_render_data);
+    
+    const StageConfig cfg = stageConfig(TUNE_STARS);
+    preCalculateStarsOMP(currentFrameTarget(), cfg);
+    
+    endVertexOutput(star_vbo, star_out, star_render_data, stars.size());
     
     auto calc_end = chrono::high_resolution_clock::now();
-    if (timing_enabled) {
-        total_parallel_time += chrono::duration<double>(calc_end - calc_start).count();
+    double t = chrono::duration<double>(calc_end - calc_start).count();
+    stageMeasured(TUNE_STARS, cfg, t);
+    if (session.timing_enabled) {
+        total_parallel_time += t;
+        stars_calc_time += t;
+    }
+}
+
+// Rasterizador por software: reparte `count` vértices desde `first` entre los hilos, que los
+// proyectan y los guardan en sus listas por tesela (las teselas se acumulan al final del frame)
+void softRasterBin(const void *data, size_t first, size_t count, float size){
+    TRACE_SCOPE("raster: reparto");
+    #pragma omp parallel num_threads(num_threads)
+    {
+        const int tid = omp_get_thread_num();
+        size_t u0, u1;
+        staticRange(count, tid, omp_get_num_threads(), u0, u1);
+        forEachVertex(data, COMPACT_VERTICES, first + u0, u1 - u0,
+            [&](float x, float y, float z, float r, float g, float b, float a){ soft_raster.binPoint(tid, x, y, z, r, g, b, a, size); });
     }
 }
 
 // Dibuja estrellas usando el buffer precomputado
 void drawStars(){
-    glDisable(GL_DEPTH_TEST);
-    glBlendFunc(GL_ONE,GL_ONE);
-    glPointSize(1.8f);
-    glBegin(GL_POINTS);
-    
+    TRACE_SCOPE("estrellas: envío");
+    auto draw_start = chrono::high_resolution_clock::now();
     
-    for(const auto &data : star_render_data){
-        if(data.visible){
-            glColor4f(data.r, data.g, data.b, data.a);
-            glVertex3f(data.x, data.y, data.z);
-        }
+    if(SOFT_RASTER){
+        softRasterBin(star_render_data.data(), 0, stars.size(), 1.8f);
+    }
+    else if(cpuFramebuffer()){
+        forEachVertex(star_render_data.data(), COMPACT_VERTICES, 0, stars.size(),
+            [](float x, float y, float z, float r, float g, float b, float a){ headless_fb.splat(x, y, z, r, g, b, a); });
     }
+#ifndef SCREENSAVER_NO_GL
+    else if(vboActive()){
+        glDisable(GL_DEPTH_TEST);
+        glBlendFunc(GL_ONE,GL_ONE);
+        glPointSize(1.8f);
+        drawVBO(star_vbo, 0, (int)stars.size());
+        glEnable(GL_DEPTH_TEST);
+    } else {
+        glDisable(GL_DEPTH_TEST);
+        glBlendFunc(GL_ONE,GL_ONE);
+        glPointSize(1.8f);
+        glBegin(GL_POINTS);
+        
+        forEachVertex(star_render_data.data(), COMPACT_VERTICES, 0, stars.size(),
+            [](float x, float y, float z, float r, float g, float b, float a){
+                glColor4f(r, g, b, a);
+                glVertex3f(x, y, z);
+            });
+        
+        glEnd();
+        glEnable(GL_DEPTH_TEST);
+    }
+#endif
     
-    glEnd();
-    glEnable(GL_DEPTH_TEST);
+    auto draw_end = chrono::high_resolution_clock::now();
+    if (session.timing_enabled) {
+        stars_draw_time += chrono::duration<double>(draw_end - draw_start).count();
+    }
 }
 
-// Pre-cálculo paralelo por “pass” de partículas
-void preCalculateParticles(float znear, float zfar, float swirl, int pass_index){
+// Kernels de los pases [K0,K1) sobre un rango de trabajo, compartidos por todos los backends del
+// motor (pass_engine.h). Se instancian por pase (o por los 6 fusionados), por recorte y por
+// formato de vértice: rangos de profundidad, giro y alfa de cada pase son constantes y sin recorte
+// la prueba desaparece. La unidad de trabajo es un bloque de SIMD_WIDTH partículas (kernel SIMD)
+// o una partícula (kernel escalar); ver passUnitsPerBlock().
+
+// Kernel vectorizado: SIMD_WIDTH partículas por instrucción.
+// Profundidad, radio, oscilación, color y desvanecimiento no dependen del pase; solo el
+// ángulo (swirl) y el rango de profundidad cambian, así que por pase queda un sincos.
+// El conteo aplica el mismo recorte que la escritura, así los desplazamientos siguen siendo exactos.
+template<int K0, int K1, bool Cull>
+PassCounts countPassRangeSIMD(int b0, int b1, const FrameTarget &ft){
+    PassCounts cnt = {};
+    const float T = ft.t;
+    const ParticleArrays &src = ft.src;
+    for(int blk = b0; blk < b1; blk++){
+        int i0 = blk * SIMD_WIDTH;
+        vfloat z = vload(src.z + i0) + vfmod(vfloat(T) * vload(src.spd + i0), 1400.f);
+        int visible = Cull ? cullLanesSIMD(*ft.cull, src, z, i0) : -1;
+        if(visible == 0) continue;
+        forPasses<K0, K1>([&](auto k){
+            constexpr PassConfig pc = PASSES[decltype(k)::value];
+            cnt[k] += __builtin_popcount(vmovemask(vle(z, vfloat(pc.znear)) & vge(z, vfloat(pc.zfar))) & visible);
+        });
+    }
+    return cnt;
+}
+
+template<int K0, int K1, bool Cull, bool Lut, class V>
+PassCounts writePassRangeSIMD(int b0, int b1, PassCounts pos, const FrameTarget &ft){
     const float INNER_R = 10.0f;
-    int base_index = pass_index * pts.size();
+    const size_t stride = ft.stride;
+    const float T = ft.t;
+    const ParticleArrays &src = ft.src;
+    
+    // Rango de profundidad que cubre todos los pases del kernel
+    constexpr float zmax = passesZNear(K0, K1), zmin = passesZFar(K0, K1);
     
-    #pragma omp parallel for num_threads(num_threads) schedule(dynamic, 50)
-    for(int i = 0; i < (int)pts.size(); i++){
-        auto &p = pts[i];
-        int data_index = base_index + i;
+    for(int blk = b0; blk < b1; blk++){
+        int i0 = blk * SIMD_WIDTH;
+        vfloat z = vload(src.z + i0) + vfmod(vfloat(T) * vload(src.spd + i0), 1400.f);
         
-        float z=p.z+fmodf(T*p.spd,1400.f);
+        // Bloque fuera de todos los pases (el relleno del SoA siempre cae aquí) o fuera de cámara
+        int in_range = vmovemask(vle(z, vfloat(zmax)) & vge(z, vfloat(zmin)));
+        if(in_range == 0) continue;
+        int visible = Cull ? cullLanesSIMD(*ft.cull, src, z, i0) : -1;
+        if((in_range & visible) == 0) continue;
         
-        if(z>znear || z<zfar) {
-            particle_render_data[data_index].visible = false;
-            continue;
-        }
+        // Términos comunes a todos los pases
+        vfloat band = vload(src.band + i0);
+        vfloat a0 = vload(src.a + i0) + vfloat(0.0019f)*z + band*vfloat(6.2831853f/7.f);
+        vfloat r = vmax(vload(src.r + i0)*(vfloat(1.f) + vfloat(0.0011f)*z), vfloat(INNER_R));
+        vfloat wob = vfloat(0.8f)*vsin(vfloat(0.7f*T) + band*vfloat(0.8f) + vfloat(0.02f)*z);
+        vfloat jitx = vload(src.jx + i0)*vsin(vfloat(0.9f*T) + vfloat(0.01f)*z);
+        vfloat jity = vload(src.jy + i0)*vcos(vfloat(0.8f*T) + vfloat(0.013f)*z);
         
-        // Trayectoria y tamaño
-        float a=p.a + swirl*T + 0.0019f*z + p.band*(6.2831853f/7.f);
-        float r=p.r*(1.f+0.0011f*z);
-        if(r<INNER_R) r=INNER_R;
-
-        // Pequeñas oscilaciones y jitter
-        float wob=0.8f*sinf(0.7f*T+p.band*0.8f+0.02f*z);
-        float x=(r+wob)*cosf(a)+p.jx*sinf(0.9f*T+0.01f*z);
-        float y=(r-wob)*sinf(a)+p.jy*cosf(0.8f*T+0.013f*z);
-
-        // Coordenadas para color
-        float u=fmodf(0.0025f*z + 0.12f*p.band,1.f);
-        float v=fabsf(z)/1400.f;
+        vfloat u = vfmod(vfloat(0.0025f)*z + vfloat(0.12f)*band, 1.f);
+        vfloat v = vabs(z)*vfloat(1.f/1400.f);
+        vfloat cr, cg, cb;
+        if constexpr (Lut) ft.palette->lookup(u, v, cr, cg, cb);
+        else colorBHv(u, v, cr, cg, cb, T);
+        vfloat glow = vfloat(0.6f) + vfloat(0.4f)*vsin(vfloat(2.4f*T) + vfloat(0.3f)*band + vfloat(0.003f)*z);
+        vfloat centerFade = vfloat(0.6f) + vfloat(0.4f/INNER_R)*r;
+        vfloat fade = (vfloat(1.f) - vmin(vfloat(1.f), v))*glow*centerFade;
         
-        float cr,cg,cb; 
-        colorBH(u,v,cr,cg,cb,T);
+        alignas(SIMD_ALIGN) float X[SIMD_WIDTH], Y[SIMD_WIDTH], Z[SIMD_WIDTH];
+        alignas(SIMD_ALIGN) float R[SIMD_WIDTH], G[SIMD_WIDTH], B[SIMD_WIDTH], A[SIMD_WIDTH];
+        // Formato compacto: se cuantiza en vectores y cada vértice son 3 palabras (xy, z, rgba)
+        alignas(SIMD_ALIGN) int32_t QXY[SIMD_WIDTH], QZ[SIMD_WIDTH], QC[SIMD_WIDTH];
+        constexpr bool compact = is_same<V, CompactVertex>::value;
+        vint rgb;
+        if constexpr (compact) {
+            vstore(QZ, quantizeFixed(z, COMPACT_Z_SCALE) & vint(0xffff));
+            rgb = quantizeUnit(cr) | vshl<8>(quantizeUnit(cg)) | vshl<16>(quantizeUnit(cb));
+        } else {
+            vstore(Z, z); vstore(R, cr); vstore(G, cg); vstore(B, cb); vstore(A, fade);
+        }
+        
+        // Parte dependiente del pase: visibilidad y posición con su swirl
+        forPasses<K0, K1>([&](auto kc){
+            constexpr int k = decltype(kc)::value;
+            constexpr PassConfig pc = PASSES[k];
+            int mask = vmovemask(vle(z, vfloat(pc.znear)) & vge(z, vfloat(pc.zfar))) & visible;
+            if(mask == 0) return;
+            
+            vfloat sa, ca;
+            vsincos(a0 + vfloat(pc.swirl*T), sa, ca);
+            vfloat px = (r + wob)*ca + jitx, py = (r - wob)*sa + jity;
+            
+            // Registro completo por vértice: en un VBO mapeado conviene escribir líneas enteras
+            V *out = (V*)ft.particles + (size_t)k * stride;
+            if constexpr (compact) {
+                vstore(QXY, (quantizeFixed(px, COMPACT_XY_SCALE) & vint(0xffff)) | vshl<16>(quantizeFixed(py, COMPACT_XY_SCALE)));
+                vstore(QC, rgb | vshl<24>(quantizeUnit(fade * vfloat(pc.alphaMul))));
+                for(int l = 0; l < SIMD_WIDTH; l++){
+                    if(!((mask >> l) & 1)) continue;
+                    const uint32_t words[3] = {(uint32_t)QXY[l], (uint32_t)QZ[l], (uint32_t)QC[l]};
+                    memcpy(&out[pos[k]++], words, sizeof(CompactVertex));
+                }
+            } else {
+                vstore(X, px);
+                vstore(Y, py);
+                for(int l = 0; l < SIMD_WIDTH; l++){
+                    if(!((mask >> l) & 1)) continue;
+                    out[pos[k]++] = makeVertex<V>(X[l], Y[l], Z[l], R[l], G[l], B[l], A[l] * pc.alphaMul);
+                }
+            }
+        });
+    }
+    return pos;
+}
+
+// Kernel escalar (referencia para comparar con el kernel SIMD): el de pass_engine.h sobre el SoA,
+// para las partículas [i_begin, i_end)
+inline auto particleLoader(const FrameTarget &ft){
+    return [&src = ft.src](int i){ return Particle{src.a[i], src.z[i], src.r[i], src.spd[i], src.band[i], src.jx[i], src.jy[i]}; };
+}
+
+template<bool Cull>
+inline auto particleCullTest(const FrameTarget &ft){
+    return [&ft](int i, float z){ return !Cull || cullParticle(*ft.cull, ft.src, i, z); };
+}
+
+template<int K0, int K1, bool Cull>
+PassCounts countPassRangeScalar(int i_begin, int i_end, const FrameTarget &ft){
+    return countPassesScalar<K0, K1>(i_begin, i_end, ft.t, particleLoader(ft), particleCullTest<Cull>(ft));
+}
+
+template<int K0, int K1, bool Cull, bool Lut, class V>
+PassCounts writePassRangeScalar(int i_begin, int i_end, PassCounts pos, const FrameTarget &ft){
+    V *out = (V*)ft.particles;
+    const size_t stride = ft.stride;
+    auto emit = [&](int k, float x, float y, float z, float r, float g, float b, float a){
+        out[(size_t)k * stride + pos[k]++] = makeVertex<V>(x, y, z, r, g, b, a);
+    };
+    if constexpr (Lut) writePassesScalar<K0, K1>(i_begin, i_end, ft.t, particleLoader(ft), particleCullTest<Cull>(ft), emit, *ft.palette);
+    else writePassesScalar<K0, K1>(i_begin, i_end, ft.t, particleLoader(ft), particleCullTest<Cull>(ft), emit, ExactPalette{ft.t});
+    return pos;
+}
+
+// Unidades de trabajo por bloque SIMD del kernel activo (el escalar trabaja por partícula)
+inline int passUnitsPerBlock(){ return SIMD_KERNEL ? 1 : SIMD_WIDTH; }
+
+// Bloques a recorrer para los pases [k0,k1) en el frame ft: con el índice, solo las cubetas que
+// pueden caer en el rango de profundidad de los pases y en rebanadas que el recorte no descarta
+void passActiveSpans(int k0, int k1, const FrameTarget &ft, ActiveSpans &spans){
+    spans.clear();
+    if(ft.index){
+        const ParticleCull *cull = ft.cull;
+        ft.index->activeSpans(ft.t, passesZFar(k0, k1), passesZNear(k0, k1),
+            [cull](float lo, float hi){ return !cull || cullDepthVisible(*cull, lo, hi); }, spans);
+        index_blocks_visited += spans.blocks;
+        index_blocks_total += ft.index->blocks();
+    } else spans.add(0, (int)((pts.size() + SIMD_WIDTH - 1) / SIMD_WIDTH));
+}
+
+// Par de kernels (conteo y escritura) de una instancia; se elige una vez por etapa
+struct PassKernels {
+    PassCounts (*count)(int u0, int u1, const FrameTarget &ft);
+    PassCounts (*write)(int u0, int u1, PassCounts pos, const FrameTarget &ft);     // devuelve pos al final
+};
+
+template<int K0, int K1, bool Cull, bool Lut, class V>
+PassKernels passKernels(){
+    if(SIMD_KERNEL) return {countPassRangeSIMD<K0, K1, Cull>, writePassRangeSIMD<K0, K1, Cull, Lut, V>};
+    return {countPassRangeScalar<K0, K1, Cull>, writePassRangeScalar<K0, K1, Cull, Lut, V>};
+}
+
+template<int K0, int K1, bool Cull, bool Lut>
+PassKernels passKernels(bool compact){
+    return compact ? passKernels<K0, K1, Cull, Lut, CompactVertex>() : passKernels<K0, K1, Cull, Lut, RenderData>();
+}
+
+// Recorte, paleta (tabla o exacta) y formato del frame se eligen aquí, no dentro de los kernels
+template<int K0, int K1>
+PassKernels passKernels(const FrameTarget &ft){
+    if(ft.cull) return ft.palette ? passKernels<K0, K1, true, true>(ft.compact) : passKernels<K0, K1, true, false>(ft.compact);
+    return ft.palette ? passKernels<K0, K1, false, true>(ft.compact) : passKernels<K0, K1, false, false>(ft.compact);
+}
+
+template<size_t... K>
+constexpr array<PassKernels (*)(const FrameTarget&), PASS_COUNT> singlePassKernels(index_sequence<K...>){
+    return {{passKernels<(int)K, (int)K + 1>...}};
+}
+
+// Kernels de los pases [k0,k1): los 6 fusionados o uno solo
+PassKernels selectPassKernels(int k0, int k1, const FrameTarget &ft){
+    static constexpr auto single = singlePassKernels(make_index_sequence<PASS_COUNT>());
+    if(k0 == 0 && k1 == PASS_COUNT) return passKernels<0, PASS_COUNT>(ft);
+    return single[k0](ft);
+}
+
+// Una etapa de pases lista para el motor: kernels elegidos, frame y bloques activos. Las unidades
+// del motor son las activas; cada rango se traduce a los tramos reales que le tocan.
+struct PassStage {
+    PassKernels kernels;
+    FrameTarget ft;
+    const ActiveSpans *spans;
+    int scale;                      // unidades por bloque
+    
+    int units() const { return spans->blocks * scale; }
+    
+    PassCounts count(int a0, int a1) const {
+        PassCounts total = {};
+        spans->forUnits(a0, a1, scale, [&](int u0, int u1){
+            PassCounts c = kernels.count(u0, u1, ft);
+            for(int k = 0; k < PASS_COUNT; k++) total[k] += c[k];
+        });
+        return total;
+    }
+    
+    PassCounts write(int a0, int a1, PassCounts pos) const {
+        spans->forUnits(a0, a1, scale, [&](int u0, int u1){ pos = kernels.write(u0, u1, pos, ft); });
+        return pos;
+    }
+};
+
+inline PassStage passStage(int k0, int k1, const FrameTarget &ft, ActiveSpans &spans){
+    passActiveSpans(k0, k1, ft, spans);
+    return {selectPassKernels(k0, k1, ft), ft, &spans, passUnitsPerBlock()};
+}
+
+// Pre-cálculo de los pases [k0,k1) con el motor de pases compactos: conteo por tramo, suma
+// prefija y escritura compacta desde el desplazamiento del tramo. Con chunk 0 hay un tramo por
+// hilo (partición estática); si no, tramos de cfg.chunk unidades repartidos con el schedule de cfg.
+// Con un hilo no se abre región paralela.
+void preCalculatePassesOMP(int k0, int k1, const FrameTarget &ft, const StageConfig &cfg){
+    ActiveSpans spans;
+    const PassStage stage = passStage(k0, k1, ft, spans);
+    const int units = stage.units();
+    const int ranges = cfg.chunk > 0 ? (units + cfg.chunk - 1) / cfg.chunk : cfg.threads;
+    vector<PassCounts> range_counts;
+    auto count = [&stage](int u0, int u1){ return stage.count(u0, u1); };
+    auto write = [&stage](int u0, int u1, const PassCounts &pos){ stage.write(u0, u1, pos); };
+    
+    if(cfg.threads <= 1){
+        SequentialBackend backend;
+        computeCompactPasses(backend, units, ranges, cfg.chunk, k0, k1, range_counts, ft.visible, count, write);
+    } else {
+        OpenMPBackend backend{cfg.threads, cfg.kind};
+        computeCompactPasses(backend, units, ranges, cfg.chunk, k0, k1, range_counts, ft.visible, count, write);
+    }
+}
+
+// Pre-cálculo de los pases [k0,k1) en una sola región paralela, escribiendo en el VBO
+// mapeado (modo VBO) o en particle_render_data. El alfa ya incluye el alphaMul del pase.
+void preCalculatePasses(int k0, int k1, const StageConfig &cfg){
+    particle_out = beginVertexOutput(particle_vbo, particle_render_data);
+    
+    preCalculatePassesOMP(k0, k1, currentFrameTarget(), cfg);
+    
+    endVertexOutput(particle_vbo, particle_out, particle_render_data, passStride() * PASS_COUNT);
+}
+
+// Pre-cálculo de los 6 pases en un solo barrido (cada partícula se lee una vez)
+void preCalculateAllPasses(){
+    TRACE_SCOPE("pases fusionados: cálculo");
+    auto calc_start = chrono::high_resolution_clock::now();
+    
+    const StageConfig cfg = stageConfig(TUNE_PASSES);
+    preCalculatePasses(0, PASS_COUNT, cfg);
+    
+    auto calc_end = chrono::high_resolution_clock::now();
+    double t = chrono::duration<double>(calc_end - calc_start).count();
+    stageMeasured(TUNE_PASSES, cfg, t);
+    if (session.timing_enabled) {
+        total_parallel_time += t;
+        fused_calc_time += t;
+    }
+}
+
+// Dibuja `count` vértices compactos desde `first` con el tamaño de punto del pase: un glDrawArrays
+// sobre el VBO (los vértices ya están subidos en esa posición), GL inmediato o framebuffer headless
+void drawPassVertices(int pass_index, const void *data, size_t first, int count){
+    if(SOFT_RASTER){
+        softRasterBin(data, first, count, PASSES[pass_index].ps);
+    }
+    else if(cpuFramebuffer()){
+        forEachVertex(data, COMPACT_VERTICES, first, count,
+            [](float x, float y, float z, float r, float g, float b, float a){ headless_fb.splat(x, y, z, r, g, b, a); });
+    }
+#ifndef SCREENSAVER_NO_GL
+    else if(vboActive()){
+        glPointSize(PASSES[pass_index].ps);
+        drawVBO(particle_vbo, (int)first, count);
+    } else {
+        glPointSize(PASSES[pass_index].ps);
+        glBegin(GL_POINTS);
         
-        // Transparencia con brillo y desvanecimiento hacia el centro
-        float glow=0.6f+0.4f*sinf(2.4f*T+0.3f*p.band+0.003f*z);
-        float centerFade = 0.6f + 0.4f*(r/INNER_R);
-        float fade=(1.f - fminf(1.f,v))*glow*centerFade;
+        forEachVertex(data, COMPACT_VERTICES, first, count,
+            [](float x, float y, float z, float r, float g, float b, float a){
+                glColor4f(r, g, b, a);
+                glVertex3f(x, y, z);
+            });
         
-        // Se llena el buffer de render
-        particle_render_data[data_index].x = x;
-        particle_render_data[data_index].y = y;
-        particle_render_data[data_index].z = z;
-        particle_render_data[data_index].r = cr;
-        particle_render_data[data_index].g = cg;
-        particle_render_data[data_index].b = cb;
-        particle_render_data[data_index].a = fade;
-        particle_render_data[data_index].visible = true;
+        glEnd();
+    }
+#endif
+}
+
+// Envía los vértices visibles (compactos) de un pase ya calculado
+void submitPass(int pass_index){
+    TRACE_SCOPE(PASS_SUBMIT_TRACE[pass_index]);
+    auto draw_start = chrono::high_resolution_clock::now();
+    
+    drawPassVertices(pass_index, particle_render_data.data(), (size_t)pass_index * passStride(), pass_visible_count[pass_index]);
+    
+    auto draw_end = chrono::high_resolution_clock::now();
+    if (session.timing_enabled) {
+        pass_draw_time[pass_index] += chrono::duration<double>(draw_end - draw_start).count();
     }
 }
 
 // Un “pass” de dibujo: pre-calcula en paralelo y dibuja los puntos visibles
-void pass(float ps, float alphaMul, float znear, float zfar, float swirl, float kdepth, int pass_index){
+void pass(int pass_index){
     auto calc_start = chrono::high_resolution_clock::now();
     
-    
-    preCalculateParticles(znear, zfar, swirl, pass_index);
+    const StageConfig cfg = stageConfig(TUNE_PASS0 + pass_index);
+    {
+        TRACE_SCOPE(PASS_CALC_TRACE[pass_index]);
+        preCalculatePasses(pass_index, pass_index + 1, cfg);
+    }
     
     auto calc_end = chrono::high_resolution_clock::now();
-    if (timing_enabled) {
-        total_parallel_time += chrono::duration<double>(calc_end - calc_start).count();
+    double t = chrono::duration<double>(calc_end - calc_start).count();
+    stageMeasured(TUNE_PASS0 + pass_index, cfg, t);
+    if (session.timing_enabled) {
+        total_parallel_time += t;
+        pass_calc_time[pass_index] += t;
     }
     
+    submitPass(pass_index);
+}
+
+// Envío por tramos (--stream, stream_ring.h): el pase se calcula por tramos de STREAM_CHUNK
+// partículas en el anillo y cada tramo se envía apenas está listo, en el orden de las partículas
+// (el mismo orden de dibujo que pass()). Cada tramo se escribe compacto desde el inicio de su
+// buffer, así que no hace falta conteo ni suma prefija; particle_render_data no se usa.
+StreamRing<RenderBuffer> stream_ring;
+
+void streamPass(int pass_index){
+    auto pass_start = chrono::high_resolution_clock::now();
+    double draw_before = pass_draw_time[pass_index];
+    
+    const StageConfig cfg = stageConfig(TUNE_PASS0 + pass_index);
+    FrameTarget ft = currentFrameTarget();
+    ft.stride = 0;                  // un solo pase por tramo: escribe desde el inicio del buffer
+    ActiveSpans spans;
+    const PassStage stage = passStage(pass_index, pass_index + 1, ft, spans);
+    const int per_unit = SIMD_WIDTH / stage.scale;         // partículas por unidad de trabajo
+    const int chunk = max(1, STREAM_CHUNK / per_unit);
+    const int units = stage.units();
+    const int chunks = (units + chunk - 1) / chunk;
+    // Dos buffers por trabajador: uno en cálculo y otro listo esperando el envío
+    stream_ring.resize(max(1, 2 * (cfg.threads - 1)),
+                       ((size_t)chunk * per_unit * vertexBytes() + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+    
+    int visible = 0;
+    stream_ring.run(chunks, cfg.threads,
+        [&](int c, RenderBuffer &buffer){
+            PassStage local = stage;
+            local.ft.particles = buffer.data();
+            return local.write(c * chunk, min(units, (c + 1) * chunk), PassCounts{})[pass_index];
+        },
+        [&](int, RenderBuffer &buffer, int count){
+            if(count == 0) return;
+            TRACE_SCOPE(PASS_SUBMIT_TRACE[pass_index]);
+            auto draw_start = chrono::high_resolution_clock::now();
+#ifndef SCREENSAVER_NO_GL
+            if(vboActive()){
+                orphanVertexBuffer(particle_vbo, (size_t)count * vertexBytes());
+                uploadVertices(particle_vbo, buffer.data(), 0, count);
+            }
+#endif
+            drawPassVertices(pass_index, buffer.data(), 0, count);
+            visible += count;
+            if (session.timing_enabled) {
+                pass_draw_time[pass_index] += chrono::duration<double>(chrono::high_resolution_clock::now() - draw_start).count();
+            }
+        });
+    pass_visible_count[pass_index] = visible;
+    
+    // El cálculo se solapa con los envíos: se cuenta como cálculo todo lo que no fue envío
+    double wall = chrono::duration<double>(chrono::high_resolution_clock::now() - pass_start).count();
+    stageMeasured(TUNE_PASS0 + pass_index, cfg, wall);
+    if (session.timing_enabled) {
+        double calc = max(0.0, wall - (pass_draw_time[pass_index] - draw_before));
+        total_parallel_time += calc;
+        pass_calc_time[pass_index] += calc;
+    }
+}
+
+#ifndef SCREENSAVER_NO_GL
+// ---------------------------------------------------------------------------
+// Modo shader: las partículas se suben una vez como atributos estáticos y toda la
+// animación (trayectoria, oscilación, paleta y desvanecimiento) se evalúa en el
+// vertex shader. El costo de CPU por frame queda en un puñado de llamadas GL.
+// ---------------------------------------------------------------------------
+
+// Mismas fórmulas que preCalculatePasses; fmodc reproduce fmodf (trunca hacia cero)
+// porque mod() de GLSL usa floor y cambia el resultado para argumentos negativos.
+const char *PARTICLE_VS = R"(#version 120
+attribute float a_a;
+attribute float a_z;
+attribute float a_r;
+attribute float a_spd;
+attribute float a_band;
+attribute float a_jx;
+attribute float a_jy;
+uniform float T, swirl, znear, zfar, alphaMul;
+varying vec4 v_color;
+
+float fmodc(float x, float y){
+    float q = x / y;
+    q = (q < 0.0) ? ceil(q) : floor(q);
+    return x - q * y;
+}
+
+vec3 colorBH(float u, float v){
+    float c1 = 0.5 + 0.5*sin(6.2831853*(u + 0.05*T));
+    float c2 = 0.5 + 0.5*sin(6.2831853*(u*0.5 + 0.3*v) + 2.1 + 0.1*T);
+    float c3 = 0.5 + 0.5*sin(6.2831853*(u*0.9 - 0.2*v) + 3.6 - 0.07*T);
+    float blue = 0.55 + 0.45*c1;
+    float purple = 0.45 + 0.55*c2;
+    float pink = 0.55 + 0.45*c3;
+    return vec3(0.25*blue + 0.35*purple + 0.80*pink,
+                0.35*blue + 0.45*purple + 0.30*pink,
+                1.00*blue + 0.60*purple + 0.20*pink);
+}
+
+void main(){
+    const float INNER_R = 10.0;
+    float z = a_z + fmodc(T*a_spd, 1400.0);
+    if(z > znear || z < zfar){
+        // Fuera del pase: se manda fuera del volumen de recorte
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        v_color = vec4(0.0);
+        return;
+    }
+    float a = a_a + swirl*T + 0.0019*z + a_band*(6.2831853/7.0);
+    float r = max(a_r*(1.0 + 0.0011*z), INNER_R);
+    float wob = 0.8*sin(0.7*T + a_band*0.8 + 0.02*z);
+    float x = (r + wob)*cos(a) + a_jx*sin(0.9*T + 0.01*z);
+    float y = (r - wob)*sin(a) + a_jy*cos(0.8*T + 0.013*z);
+    float u = fmodc(0.0025*z + 0.12*a_band, 1.0);
+    float v = abs(z)/1400.0;
+    float glow = 0.6 + 0.4*sin(2.4*T + 0.3*a_band + 0.003*z);
+    float centerFade = 0.6 + 0.4*(r/INNER_R);
+    float fade = (1.0 - min(1.0, v))*glow*centerFade;
+    gl_Position = gl_ModelViewProjectionMatrix * vec4(x, y, z, 1.0);
+    v_color = vec4(colorBH(u, v), fade*alphaMul);
+}
+)";
+
+const char *STAR_VS = R"(#version 120
+attribute float a_x;
+attribute float a_y;
+attribute float a_z;
+attribute float a_phase;
+uniform float T;
+varying vec4 v_color;
+
+void main(){
+    float tw = 0.65 + 0.35*sin(0.6*T + a_phase*3.0);
+    gl_Position = gl_ModelViewProjectionMatrix * vec4(a_x, a_y, a_z, 1.0);
+    v_color = vec4(0.45*tw, 0.55*tw, 1.0*tw, 1.0);
+}
+)";
+
+const char *COLOR_FS = R"(#version 120
+varying vec4 v_color;
+void main(){ gl_FragColor = v_color; }
+)";
+
+// Programas, ubicaciones de uniforms y buffers de atributos estáticos
+struct ShaderState {
+    bool ready = false;
+    GLuint particle_program = 0, star_program = 0;
+    GLuint particle_attr_vbo = 0, star_attr_vbo = 0;
+    GLint uT = -1, uSwirl = -1, uZnear = -1, uZfar = -1, uAlphaMul = -1;
+    GLint uStarT = -1;
+} shader;
+
+const char *PARTICLE_ATTRS[] = {"a_a", "a_z", "a_r", "a_spd", "a_band", "a_jx", "a_jy"};
+const char *STAR_ATTRS[] = {"a_x", "a_y", "a_z", "a_phase"};
+
+// Compila un shader; devuelve 0 (y muestra el log) si falla
+GLuint compileShader(GLenum type, const char *src){
+    GLuint sh = glCreateShader(type);
+    glShaderSource(sh, 1, &src, NULL);
+    glCompileShader(sh);
+    GLint ok = 0;
+    glGetShaderiv(sh, GL_COMPILE_STATUS, &ok);
+    if(!ok){
+        char log[1024];
+        glGetShaderInfoLog(sh, sizeof(log), NULL, log);
+        cerr << "Error compilando shader: " << log << endl;
+        glDeleteShader(sh);
+        return 0;
+    }
+    return sh;
+}
+
+// Enlaza vertex + fragment fijando las ubicaciones de los atributos en orden (0..count-1)
+GLuint linkProgram(const char *vs_src, const char *fs_src, const char **attrs, int count){
+    GLuint vs = compileShader(GL_VERTEX_SHADER, vs_src);
+    GLuint fs = compileShader(GL_FRAGMENT_SHADER, fs_src);
+    if(!vs || !fs) return 0;
+    GLuint prog = glCreateProgram();
+    glAttachShader(prog, vs);
+    glAttachShader(prog, fs);
+    for(int i = 0; i < count; i++) glBindAttribLocation(prog, i, attrs[i]);
+    glLinkProgram(prog);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+    GLint ok = 0;
+    glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+    if(!ok){
+        char log[1024];
+        glGetProgramInfoLog(prog, sizeof(log), NULL, log);
+        cerr << "Error enlazando programa: " << log << endl;
+        glDeleteProgram(prog);
+        return 0;
+    }
+    return prog;
+}
+
+// Compila los programas (una vez, con el contexto GL creado). Si el driver no soporta
+// GLSL 1.20 el modo shader queda deshabilitado y se sigue con el camino de CPU.
+void initShaders(){
+    shader.particle_program = linkProgram(PARTICLE_VS, COLOR_FS, PARTICLE_ATTRS, 7);
+    shader.star_program = linkProgram(STAR_VS, COLOR_FS, STAR_ATTRS, 4);
+    if(!shader.particle_program || !shader.star_program){
+        cerr << "Modo shader no disponible; se usa el pre-cálculo en CPU" << endl;
+        return;
+    }
+    shader.uT = glGetUniformLocation(shader.particle_program, "T");
+    shader.uSwirl = glGetUniformLocation(shader.particle_program, "swirl");
+    shader.uZnear = glGetUniformLocation(shader.particle_program, "znear");
+    shader.uZfar = glGetUniformLocation(shader.particle_program, "zfar");
+    shader.uAlphaMul = glGetUniformLocation(shader.particle_program, "alphaMul");
+    shader.uStarT = glGetUniformLocation(shader.star_program, "T");
+    glGenBuffers(1, &shader.particle_attr_vbo);
+    glGenBuffers(1, &shader.star_attr_vbo);
+    shader.ready = true;
+}
+
+// Sube partículas (los 7 arreglos SoA uno tras otro, separados por la capacidad) y estrellas;
+// se llama después de gen(). Con first > 0 solo se suben las partículas [first, n) al buffer existente.
+void uploadShaderAttributes(size_t first){
+    if(!shader.ready) return;
+    const size_t field_bytes = passStride() * sizeof(float);
+    const float *fields[] = {pts.a, pts.z, pts.r, pts.spd, pts.band, pts.jx, pts.jy};
+    const size_t offset = first * sizeof(float), bytes = (pts.size() - first) * sizeof(float);
+    glBindBuffer(GL_ARRAY_BUFFER, shader.particle_attr_vbo);
+    if(first == 0) glBufferData(GL_ARRAY_BUFFER, 7 * field_bytes, NULL, GL_STATIC_DRAW);
+    for(int f = 0; f < 7; f++) glBufferSubData(GL_ARRAY_BUFFER, f * field_bytes + offset, bytes, fields[f] + first);
+    
+    if(first == 0){
+        glBindBuffer(GL_ARRAY_BUFFER, shader.star_attr_vbo);
+        glBufferData(GL_ARRAY_BUFFER, stars.size() * sizeof(Particle), stars.data(), GL_STATIC_DRAW);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Estrellas en modo shader: el brillo se calcula en la GPU
+void drawStarsShader(){
+    auto draw_start = chrono::high_resolution_clock::now();
+    
+    glDisable(GL_DEPTH_TEST);
+    glBlendFunc(GL_ONE,GL_ONE);
+    glPointSize(1.8f);
+    glUseProgram(shader.star_program);
+    glUniform1f(shader.uStarT, T);
+    glBindBuffer(GL_ARRAY_BUFFER, shader.star_attr_vbo);
+    const size_t offsets[] = {offsetof(Particle, r), offsetof(Particle, spd), offsetof(Particle, z), offsetof(Particle, a)};
+    for(int i = 0; i < 4; i++){
+        glEnableVertexAttribArray(i);
+        glVertexAttribPointer(i, 1, GL_FLOAT, GL_FALSE, sizeof(Particle), (const void*)offsets[i]);
+    }
+    glDrawArrays(GL_POINTS, 0, (int)stars.size());
+    for(int i = 0; i < 4; i++) glDisableVertexAttribArray(i);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glUseProgram(0);
+    glEnable(GL_DEPTH_TEST);
     
-    glPointSize(ps);
-    glBegin(GL_POINTS);
+    auto draw_end = chrono::high_resolution_clock::now();
+    if (session.timing_enabled) {
+        stars_draw_time += chrono::duration<double>(draw_end - draw_start).count();
+    }
+}
+
+// Los 6 pases en modo shader: mismos atributos, cambian solo los uniforms del pase
+void drawPassesShader(){
+    glUseProgram(shader.particle_program);
+    glUniform1f(shader.uT, T);
+    glBindBuffer(GL_ARRAY_BUFFER, shader.particle_attr_vbo);
+    const size_t field_bytes = passStride() * sizeof(float);
+    for(int f = 0; f < 7; f++){
+        glEnableVertexAttribArray(f);
+        glVertexAttribPointer(f, 1, GL_FLOAT, GL_FALSE, 0, (const void*)(f * field_bytes));
+    }
     
-    int base_index = pass_index * pts.size();
-    for(int i = 0; i < (int)pts.size(); i++){
-        const auto &data = particle_render_data[base_index + i];
-        if(data.visible){
-            glColor4f(data.r, data.g, data.b, data.a * alphaMul);
-            glVertex3f(data.x, data.y, data.z);
+    for(int k = 0; k < PASS_COUNT; k++){
+        TRACE_SCOPE(PASS_SUBMIT_TRACE[k]);
+        auto draw_start = chrono::high_resolution_clock::now();
+        
+        const PassConfig &pc = PASSES[k];
+        glUniform1f(shader.uSwirl, pc.swirl);
+        glUniform1f(shader.uZnear, pc.znear);
+        glUniform1f(shader.uZfar, pc.zfar);
+        glUniform1f(shader.uAlphaMul, pc.alphaMul);
+        glPointSize(pc.ps);
+        glDrawArrays(GL_POINTS, 0, (int)pts.size());
+        
+        auto draw_end = chrono::high_resolution_clock::now();
+        if (session.timing_enabled) {
+            pass_draw_time[k] += chrono::duration<double>(draw_end - draw_start).count();
         }
     }
     
-    glEnd();
+    for(int f = 0; f < 7; f++) glDisableVertexAttribArray(f);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glUseProgram(0);
 }
 
 // HUD de FPS e información de control
 void drawFPS() {
-    if (!showFPS) return;
+    drawHud(session, camera, W, H, [](HudText &hud){
+        hud.print("FPS: %.1f | Hilos: %d | Partículas: %d | Matemática: %dx | Frames: %d | Tiempo: %.2fs | PARALELO",
+                  session.currentFPS, num_threads, PARTICLE_COUNT, MATH_ITERATIONS, session.frame_count_timing, session.total_computation_time);
+        hud.print("Ops/frame: ~%d | Estrellas: %d | [+/-] Cambiar hilos | [ESC] Salir",
+                  PARTICLE_COUNT * MATH_ITERATIONS * 10, STAR_COUNT);
+        hud.line("[C] Camara | [F] FPS | [G] Shader/OpenMP | [T] Tareas/OpenMP | [P] Pipeline | [U] Autoajuste | [V] Vertices | [K] Recorte | [R] Raster SW | [I] Indice | [L] Paleta | [ y ] Particulas -/+");
+    }, [](HudText &hud){
+        const LatencyStages &l = session.latency_hud;
+        hud.print("p95 ms  Estrellas: %.2f + %.2f | Pases: %.2f + %.2f | Swap: %.2f  (calculo + envio)",
+                  l.hist[LAT_STARS_CALC].percentileMs(95), l.hist[LAT_STARS_DRAW].percentileMs(95),
+                  l.hist[LAT_PASS_CALC].percentileMs(95), l.hist[LAT_PASS_DRAW].percentileMs(95),
+                  l.hist[LAT_SWAP].percentileMs(95));
+        
+        // Con pipeline cada frame se muestra después de calculado: latencia añadida y error de la predicción de T
+        if (pipelineActive()) {
+            const LatencyHistogram &ph = l.hist[LAT_PIPELINE];
+            hud.print("Pipeline x%d | Latencia calculo->envio p50: %.2f | p95: %.2f ms | Desfase de T: %+.2f ms",
+                      PIPELINE_DEPTH, ph.percentileMs(50), ph.percentileMs(95), pipeline_t_error * 1000.0f);
+        }
+        
+        // Configuración elegida (o en prueba) por el autoajuste para las estrellas y los pases
+        if (AUTOTUNE) {
+            const int pass_stage = FUSED_PASSES ? TUNE_PASSES : TUNE_PASS0;
+            const StageConfig &sc = stage_tuners[TUNE_STARS].current(), &pc = stage_tuners[pass_stage].current();
+            hud.print("Autoajuste | Estrellas: %d hilos %s/%d%s | %s: %d hilos %s/%d%s",
+                      sc.threads, scheduleName(sc.kind), sc.chunk, stage_tuners[TUNE_STARS].settled() ? "" : " (probando)",
+                      FUSED_PASSES ? "Pases" : "Pase 0", pc.threads, scheduleName(pc.kind), pc.chunk,
+                      stage_tuners[pass_stage].settled() ? "" : " (probando)");
+        }
+    });
+}
+
+#endif
+
+// Estrellas y seis pases de partículas (común a GLUT y headless)
+// Frame con el planificador de tareas (--tasks): mismo resultado que el camino fusionado con OpenMP,
+// pero sin barreras entre etapas. Grafo:
+//   estrellas por tramos -> [subida de cada tramo] -> envío de estrellas -> envío pase 0 -> ... -> pase 5
+//   conteo por tramo de partículas -> suma prefija -> escritura por tramo -> [subida del tramo] -> envío pase 0
+// Las tareas GL (subidas y envíos) corren en el hilo principal; mientras tanto los trabajadores siguen
+// calculando, así que las estrellas se envían mientras se cuentan partículas y cada tramo se sube
+// mientras se escriben los demás.
+TaskPool task_pool;
+vector<PassCounts> task_offsets;    // conteo y luego desplazamiento de cada tramo por pase
+
+void renderSceneTasks(){
+    task_pool.resize(num_threads);
+    auto graph_start = chrono::high_resolution_clock::now();
+    double draw_before = stars_draw_time;
+    for(int k = 0; k < PASS_COUNT; k++) draw_before += pass_draw_time[k];
     
-    frameCount++;
-    float currentTime = now();
-    if (currentTime - lastTime >= 1.0f) {
-        currentFPS = frameCount / (currentTime - lastTime);
-        frameCount = 0;
-        lastTime = currentTime;
+    // Siempre se escribe en los vectores de CPU; en modo VBO cada tramo se sube apenas está listo
+    star_out = star_render_data.data();
+    particle_out = particle_render_data.data();
+    const FrameTarget ft = currentFrameTarget();
+#ifndef SCREENSAVER_NO_GL
+    const bool upload = vboActive();
+    if(upload){
+        orphanVertexBuffer(star_vbo, bufferBytes(star_render_data));
+        orphanVertexBuffer(particle_vbo, bufferBytes(particle_render_data));
     }
+#endif
     
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadIdentity();
-    glOrtho(0, W, 0, H, -1, 1);
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
+    TaskGraph g;
     
-    glDisable(GL_DEPTH_TEST);
-    glColor3f(0.0f, 1.0f, 0.0f);
+    // Envíos en el orden de dibujo: estrellas y luego los pases 0..5
+    int star_submit = g.add("GL: envío", []{ drawStars(); }, true);
+    int submit[PASS_COUNT];
+    for(int k = 0; k < PASS_COUNT; k++){
+        submit[k] = g.add("GL: envío", [k]{ submitPass(k); }, true);
+        g.depend(k == 0 ? star_submit : submit[k - 1], submit[k]);
+    }
     
-    char fpsStr[400];
-    sprintf(fpsStr, "FPS: %.1f | Hilos: %d | Partículas: %d | Matemática: %dx | Frames: %d | Tiempo: %.2fs | PARALELO", 
-            currentFPS, num_threads, PARTICLE_COUNT, MATH_ITERATIONS, frame_count_timing, total_computation_time);
+    // Estrellas por tramos
+    const int m = (int)stars.size();
+    for(int s0 = 0; s0 < m; s0 += STAR_CHUNK){
+        int s1 = min(m, s0 + STAR_CHUNK);
+        int calc = g.add("estrellas: tramo", [s0, s1, ft]{ for(int i = s0; i < s1; i++) computeStar(i, ft); });
+        int last = calc;
+#ifndef SCREENSAVER_NO_GL
+        if(upload){
+            last = g.add("GL: subida", [s0, s1]{ uploadVertices(star_vbo, star_render_data.data(), s0, s1 - s0); }, true);
+            g.depend(calc, last);
+        }
+#endif
+        g.depend(last, star_submit);
+    }
+    
+    // Partículas: los 6 pases fusionados, por tramos de PASS_CHUNK partículas
+    ActiveSpans spans;
+    const PassStage stage = passStage(0, PASS_COUNT, ft, spans);
+    const int units = stage.units();
+    const int chunk = max(1, SIMD_KERNEL ? PASS_CHUNK / SIMD_WIDTH : PASS_CHUNK);
+    const int chunks = (units + chunk - 1) / chunk;
+    TaskBackend backend{g};
+    computeCompactPasses(backend, units, chunks, chunk, 0, PASS_COUNT, task_offsets, pass_visible_count,
+        [&stage](int u0, int u1){ return stage.count(u0, u1); },
+        [&stage](int u0, int u1, const PassCounts &pos){ stage.write(u0, u1, pos); });
+    if(chunks == 0) g.depend(backend.scan_task, submit[0]);
+    for(int c = 0; c < chunks; c++){
+        int last = backend.write_tasks[c];
+#ifndef SCREENSAVER_NO_GL
+        if(upload){
+            // Porción del tramo en cada pase: de su desplazamiento al del tramo siguiente
+            last = g.add("GL: subida", [c, chunks]{
+                for(int k = 0; k < PASS_COUNT; k++){
+                    int first = task_offsets[c][k];
+                    int end = c + 1 < chunks ? task_offsets[c + 1][k] : pass_visible_count[k];
+                    uploadVertices(particle_vbo, particle_render_data.data(), (size_t)k * passStride() + first, end - first);
+                }
+            }, true);
+            g.depend(backend.write_tasks[c], last);
+        }
+#endif
+        g.depend(last, submit[0]);
+    }
     
-    glRasterPos2f(10, H - 25);
-    for (char* c = fpsStr; *c; c++) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, *c);
+    task_pool.run(g);
+    
+    // El cálculo se solapa con los envíos: se cuenta como cálculo todo lo que no fue envío
+    double wall = chrono::duration<double>(chrono::high_resolution_clock::now() - graph_start).count();
+    double draw_after = stars_draw_time;
+    for(int k = 0; k < PASS_COUNT; k++) draw_after += pass_draw_time[k];
+    if (session.timing_enabled) {
+        double calc = max(0.0, wall - (draw_after - draw_before));
+        total_parallel_time += calc;
+        fused_calc_time += calc;
+    }
+}
+
+// Pipeline de frames (--pipeline N): un hilo productor calcula con la región OpenMP fusionada los
+// frames siguientes en N juegos de buffers mientras el hilo principal envía el actual. Cada frame
+// se calcula para el T en que se espera mostrarlo: en headless es exacto (f * dt, mismo checksum que
+// sin pipeline); con ventana se predice con la duración media del frame. Los N juegos incluyen el
+// del camino normal: mientras corre el pipeline, particle_render_data y star_render_data solo tienen
+// datos durante el envío (el juego tomado se intercambia con ellos, sin copias).
+struct PipelineSlot {
+    RenderBuffer particles, stars;
+    int visible[PASS_COUNT] = {0};
+    float t = 0.f;                  // instante de la animación para el que se calcula
+    StageConfig stars_cfg, passes_cfg;
+    bool compact = false;           // formato de vértices de los buffers
+    bool culled = false;            // recorte con la cámara del momento del pedido
+    ParticleCull cull;
+    int palette_res = 0;            // puntos por eje de la tabla de paleta (0: colorBH exacto)
+    PaletteLUT palette;             // tabla del instante t, la arma el productor
+    chrono::high_resolution_clock::time_point compute_start;
+    double stars_seconds = 0.0, passes_seconds = 0.0;
+};
+
+FramePipeline<PipelineSlot> frame_pipeline;
+int pipeline_slot = -1;             // juego en envío en este frame
+int pipeline_frame = 0;             // número del frame en envío
+float pipeline_frame_t = 0.f;       // T real del frame en envío
+float pipeline_period = 1.f / 60.f; // duración media del frame con ventana (para predecir T)
+
+// Modo shader: nada que pre-calcular, el pipeline no aplica. Con --stream no hay buffer de pases completo.
+inline bool pipelineActive(){
+#ifndef SCREENSAVER_NO_GL
+    if(SHADER_RENDER && shader.ready && !cpuFramebuffer()) return false;
+#endif
+    if(STREAM_PASSES) return false;
+    return PIPELINE_DEPTH > 1;
+}
+
+// Productor: mismos kernels que el camino fusionado, sobre los buffers del juego
+void computePipelineSlot(PipelineSlot &s){
+    TRACE_SCOPE("pipeline: cálculo");
+    s.compute_start = chrono::high_resolution_clock::now();
+    const FrameTarget ft = frameTarget(s.t, s.particles.data(), s.stars.data(), s.visible, s.compact, s.culled ? &s.cull : nullptr,
+                                       s.palette_res > 0 ? &s.palette : nullptr);
+    preCalculateStarsOMP(ft, s.stars_cfg);
+    auto stars_end = chrono::high_resolution_clock::now();
+    if(s.palette_res > 0) s.palette.build(s.palette_res, s.t, s.passes_cfg.threads);
+    preCalculatePassesOMP(0, PASS_COUNT, ft, s.passes_cfg);
+    auto passes_end = chrono::high_resolution_clock::now();
+    s.stars_seconds = chrono::duration<double>(stars_end - s.compute_start).count();
+    s.passes_seconds = chrono::duration<double>(passes_end - stars_end).count();
+}
+
+// Pide el frame `frame` en el juego i con los parámetros actuales (el productor no lee globales)
+void pipelineRequest(int i, int frame){
+    PipelineSlot &s = frame_pipeline.slot(i);
+    s.t = headless.enabled ? frame * headless.dt : pipeline_frame_t + (frame - pipeline_frame) * pipeline_period;
+    s.stars_cfg = stageConfig(TUNE_STARS);
+    s.passes_cfg = stageConfig(TUNE_PASSES);
+    s.compact = COMPACT_VERTICES;
+    s.culled = FRUSTUM_CULL;
+    if(s.culled) buildParticleCull(s.t, s.cull);   // la cámara libre puede moverse antes del envío: cubre el margen
+    s.palette_res = PALETTE_LUT ? PALETTE_RES : 0;
+    frame_pipeline.request(i);
+}
+
+// Detiene el productor y devuelve un juego al camino normal (al cambiar de modo o de partículas)
+void pipelineStop(){
+    if(frame_pipeline.depth() == 0) return;
+    frame_pipeline.stop();
+    if(particle_render_data.empty()){
+        particle_render_data.swap(frame_pipeline.slot(0).particles);
+        star_render_data.swap(frame_pipeline.slot(0).stars);
     }
+    frame_pipeline.reset();
+}
+
+// Toma el frame ya calculado (arrancando el pipeline si hace falta) y devuelve su T
+float pipelineBeginFrame(int frame, float t){
+    if(!headless.enabled && frame > pipeline_frame && t > pipeline_frame_t){
+        pipeline_period = 0.9f * pipeline_period + 0.1f * (t - pipeline_frame_t) / (frame - pipeline_frame);
+    }
+    pipeline_frame = frame;
+    pipeline_frame_t = t;
     
-    char infoStr[250];
-    sprintf(infoStr, "Ops/frame: ~%d | Estrellas: %d | [+/-] Cambiar hilos | [ESC] Salir", 
-            PARTICLE_COUNT * MATH_ITERATIONS * 10, STAR_COUNT);
-    glRasterPos2f(10, H - 45);
-    for (char* c = infoStr; *c; c++) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, *c);
+    if(frame_pipeline.depth() == 0){
+        frame_pipeline.start(PIPELINE_DEPTH, computePipelineSlot);
+        for(int i = 0; i < PIPELINE_DEPTH; i++){
+            PipelineSlot &s = frame_pipeline.slot(i);
+            if(i == 0){
+                s.particles.swap(particle_render_data);
+                s.stars.swap(star_render_data);
+            } else {
+                allocRenderBuffer(s.particles, passStride(), PASS_COUNT);
+                allocRenderBuffer(s.stars, stars.size(), 1);
+            }
+            pipelineRequest(i, frame + i);
+        }
     }
     
-    char controlStr[] = "[C] Camara | [F] FPS";
-    glRasterPos2f(10, H - 65);
-    for (char* c = controlStr; *c; c++) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, *c);
+    {
+        TRACE_SCOPE("pipeline: espera");
+        pipeline_slot = frame_pipeline.acquire();
     }
+    PipelineSlot &s = frame_pipeline.slot(pipeline_slot);
+    particle_render_data.swap(s.particles);
+    star_render_data.swap(s.stars);
+    copy(s.visible, s.visible + PASS_COUNT, pass_visible_count);
     
-    if (camera.freeMode) {
-        char moveStr[] = "WASD: Movimiento | QE: Arriba/Abajo | Mouse: Mirar";
-        glRasterPos2f(10, H - 85);
-        for (char* c = moveStr; *c; c++) {
-            glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, *c);
+    pipeline_frame_latency = chrono::duration<double>(chrono::high_resolution_clock::now() - s.compute_start).count();
+    pipeline_t_error = s.t - t;
+    if(s.palette_res > 0) palette_max_error = max(palette_max_error, s.palette.maxError());
+    stageMeasured(TUNE_STARS, s.stars_cfg, s.stars_seconds);
+    stageMeasured(TUNE_PASSES, s.passes_cfg, s.passes_seconds);
+    if (session.timing_enabled) {
+        total_parallel_time += s.stars_seconds + s.passes_seconds;
+        stars_calc_time += s.stars_seconds;
+        fused_calc_time += s.passes_seconds;
+    }
+    return s.t;
+}
+
+// T del frame `frame`: el dado o, con el pipeline activo, el del frame calculado de antemano
+float beginFrameTime(int frame, float t){
+    if(!pipelineActive()){
+        pipelineStop();
+        return t;
+    }
+    return pipelineBeginFrame(frame, t);
+}
+
+#ifndef SCREENSAVER_NO_GL
+// Sube el frame tomado al VBO: estrellas completas y la porción visible de cada pase
+void uploadPipelineFrame(){
+    TRACE_SCOPE("GL: subida");
+    auto upload_start = chrono::high_resolution_clock::now();
+    orphanVertexBuffer(star_vbo, bufferBytes(star_render_data));
+    uploadVertices(star_vbo, star_render_data.data(), 0, stars.size());
+    auto stars_end = chrono::high_resolution_clock::now();
+    orphanVertexBuffer(particle_vbo, bufferBytes(particle_render_data));
+    for(int k = 0; k < PASS_COUNT; k++){
+        auto pass_start = chrono::high_resolution_clock::now();
+        uploadVertices(particle_vbo, particle_render_data.data(), (size_t)k * passStride(), pass_visible_count[k]);
+        if (session.timing_enabled) {
+            pass_draw_time[k] += chrono::duration<double>(chrono::high_resolution_clock::now() - pass_start).count();
         }
     }
+    if (session.timing_enabled) {
+        stars_draw_time += chrono::duration<double>(stars_end - upload_start).count();
+    }
+}
+#endif
+
+// Envío de un frame del pipeline; al terminar, el juego vuelve al productor para el frame
+// pipeline_frame + PIPELINE_DEPTH
+void renderScenePipelined(){
+#ifndef SCREENSAVER_NO_GL
+    if(vboActive()) uploadPipelineFrame();
+#endif
+    drawStars();
+    for(int k = 0; k < PASS_COUNT; k++) submitPass(k);
     
-    glEnable(GL_DEPTH_TEST);
-    glPopMatrix();
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
-    glMatrixMode(GL_MODELVIEW);
+    PipelineSlot &s = frame_pipeline.slot(pipeline_slot);
+    s.particles.swap(particle_render_data);
+    s.stars.swap(star_render_data);
+    pipelineRequest(pipeline_slot, pipeline_frame + PIPELINE_DEPTH);
 }
 
-// Dibujo de un frame: cámara, estrellas y 6 pases de partículas
-void draw(){
-    auto draw_start = chrono::high_resolution_clock::now();
+// Tabla de paleta del instante T para los pases del frame normal (--palette), con su error medido
+void buildFramePalette(){
+    TRACE_SCOPE("paleta: tabla");
+    auto start = chrono::high_resolution_clock::now();
+    frame_palette.build(PALETTE_RES, T, num_threads);
+    palette_max_error = max(palette_max_error, frame_palette.maxError());
+    if (session.timing_enabled) {
+        double t = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        palette_time += t;
+        total_parallel_time += t;
+    }
+}
+
+void renderScene(){
+#ifndef SCREENSAVER_NO_GL
+    // Modo shader: nada que pre-calcular en CPU
+    if(SHADER_RENDER && shader.ready && !cpuFramebuffer()){
+        drawStarsShader();
+        drawPassesShader();
+        return;
+    }
+#endif
     
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_ONE,GL_ONE);
-    glDisable(GL_LIGHTING);
-    camera_control();
+    // El pipeline tiene prioridad sobre el grafo de tareas (calcula con la región OpenMP fusionada)
+    if(pipelineActive()){
+        renderScenePipelined();
+        return;
+    }
+    
+    if(FRUSTUM_CULL) buildParticleCull(T, frame_cull);
+    if(PALETTE_LUT) buildFramePalette();
+    
+    if(TASK_SCHEDULER && !STREAM_PASSES){
+        renderSceneTasks();
+        return;
+    }
     
     // Estrellas (pre-cálculo paralelo + dibujo)
     preCalculateStars();
     drawStars();
     
     // Seis pasadas con distintos parámetros (profundidad, tamaño, swirl)
-    pass(1.5f,0.15f,1200.f,-3000.f,0.25f,0.0019f,0);
-    pass(1.8f,0.25f,900.f,-2600.f,0.35f,0.0019f,1);
-    pass(2.2f,0.40f,600.f,-2000.f,0.40f,0.0021f,2);
-    pass(2.6f,0.50f,280.f,-1200.f,0.45f,0.0021f,3);
-    pass(3.5f,0.75f,150.f,-800.f,0.50f,0.0023f,4);
-    pass(4.2f,0.95f,80.f,-520.f,0.55f,0.0023f,5);
-    
-    glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
-    drawFPS();
-    
-    auto draw_end = chrono::high_resolution_clock::now();
-    if (timing_enabled) {
-        total_draw_time += chrono::duration<double>(draw_end - draw_start).count();
+    if(STREAM_PASSES){
+        for(int k = 0; k < PASS_COUNT; k++) streamPass(k);
+    } else if(FUSED_PASSES){
+        preCalculateAllPasses();
+        for(int k = 0; k < PASS_COUNT; k++) submitPass(k);
+    } else {
+        for(int k = 0; k < PASS_COUNT; k++) pass(k);
     }
 }
 
-// Callback principal de dibujo de GLUT: mide el tiempo de cada frame
-void display(){
-    if (timing_enabled) {
-        frame_start = chrono::high_resolution_clock::now();
+// Modo shader: los puntos los dibuja la GPU, el rasterizador por software no aplica
+inline bool softRasterActive(){
+#ifndef SCREENSAVER_NO_GL
+    if(SHADER_RENDER && shader.ready && !cpuFramebuffer()) return false;
+#endif
+    return SOFT_RASTER;
+}
+
+// Cámara del frame y listas vacías antes de los envíos
+void softRasterBegin(){
+    float mvp[16];
+    cameraViewProjection(T, mvp);
+    const float clear[4] = {0.02f, 0.02f, 0.06f, 1.f};
+    soft_raster.beginFrame(W, H, mvp, num_threads, clear);
+}
+
+#ifndef SCREENSAVER_NO_GL
+// Presenta la imagen resuelta como una textura a pantalla completa (filas de abajo hacia arriba)
+void presentSoftRaster(){
+    if(!raster_texture){
+        glGenTextures(1, &raster_texture);
+        glBindTexture(GL_TEXTURE_2D, raster_texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     }
+    glBindTexture(GL_TEXTURE_2D, raster_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, soft_raster.width(), soft_raster.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 soft_raster.image().data());
     
-    T=now();
-    glClearColor(0.02f,0.02f,0.06f,1.f);
-    glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
     glLoadIdentity();
-    draw();
-    glutSwapBuffers();
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glEnable(GL_TEXTURE_2D);
+    glColor4f(1.f, 1.f, 1.f, 1.f);
+    glBegin(GL_QUADS);
+    glTexCoord2f(0.f, 0.f); glVertex2f(-1.f, -1.f);
+    glTexCoord2f(1.f, 0.f); glVertex2f( 1.f, -1.f);
+    glTexCoord2f(1.f, 1.f); glVertex2f( 1.f,  1.f);
+    glTexCoord2f(0.f, 1.f); glVertex2f(-1.f,  1.f);
+    glEnd();
+    glDisable(GL_TEXTURE_2D);
+    glEnable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+#endif
+
+// Acumula y resuelve las teselas en paralelo y, con GL, presenta la imagen
+void softRasterEnd(){
+    TRACE_SCOPE("raster: teselas");
+    auto raster_start = chrono::high_resolution_clock::now();
     
-    if (timing_enabled) {
-        frame_end = chrono::high_resolution_clock::now();
-        total_computation_time += chrono::duration<double>(frame_end - frame_start).count();
-        frame_count_timing++;
-        
-        // Mensaje periódico para seguimiento en consola
-        if (frame_count_timing % 1000 == 0) {
-            cout << "Frames procesados: " << frame_count_timing << 
-                    ", Tiempo promedio por frame: " << 
-                    (total_computation_time / frame_count_timing) * 1000 << " ms" << 
-                    ", FPS actual: " << currentFPS << 
-                    ", Hilos: " << num_threads << endl;
+    soft_raster.rasterize(num_threads);
+#ifndef SCREENSAVER_NO_GL
+    if(!cpuFramebuffer()) presentSoftRaster();
+#endif
+    
+    if (session.timing_enabled) {
+        raster_time += chrono::duration<double>(chrono::high_resolution_clock::now() - raster_start).count();
+    }
+}
+
+void resizeParticles(int n);
+#ifndef SCREENSAVER_NO_GL
+void draw();
+#endif
+
+// Política de la versión paralela para el armazón común (app_shell.h): campo SoA generado con
+// OpenMP y mapeado directo de la caché, buffers de render, recorte e índice por campo, y las
+// etapas de cálculo/envío, raster, paleta y pipeline en el frame y el reporte
+struct ParallelApp {
+    struct Initial { vector<float> a0, jx0; };  // valores previos a la carga SIMD (solo si se valida)
+    const char *name = "PARALELO";
+    const char *gen_name = "PARALELA";
+    const char *bench_name = "paralelo";
+    size_t old_capacity = 0;    // capacidad del SoA antes de un cambio de cantidad
+    double index_time = 0.0;    // armado del índice de visibilidad tras generar
+    
+    // Campo
+    FieldOptions options() const {
+        return {STAR_COUNT, MATH_ITERATIONS, !HEAVY_MATH_MODE ? 0 : FAST_MATH ? 2 : 1, VALIDATE_MATH, PARTICLE_CACHE, CACHE_DIR};
+    }
+    int size() const { return (int)pts.size(); }
+    void create(int n){ pts.resize(n); }
+    // Los buffers de render se reubican solo si se supera la capacidad
+    void resize(int n){
+        pts.resize(n);
+        if(pts.capacity != old_capacity) allocRenderBuffer(particle_render_data, passStride(), particleBufferSlices());
+    }
+    void generate(int i0, int i1, Initial &initial){ generateParticles(i0, i1, initial.a0, initial.jx0); }
+    void generateStars(){ ::generateStars(); }
+    void validate(int i0, const Initial &initial){ validateParticles(i0, initial.a0, initial.jx0); }
+    vector<Particle> &stars(){ return ::stars; }
+    void adopt(ParticleCacheMap &map){ pts.adopt(map); }     // el SoA apunta directo al mapeo
+    float cacheField(int f, size_t i) const {
+        const float *fields[] = {pts.a, pts.z, pts.r, pts.spd, pts.band, pts.jx, pts.jy};
+        return fields[f][i];
+    }
+    // Buffers de render (6 pases y estrellas)
+    void allocate(){
+        allocRenderBuffer(particle_render_data, passStride(), particleBufferSlices());
+        allocRenderBuffer(star_render_data, STAR_COUNT, 1);
+    }
+    void fieldChanged(){
+        updateCullBounds();
+        auto index_start = chrono::high_resolution_clock::now();
+        buildVisibilityIndex();
+        index_time = chrono::duration<double>(chrono::high_resolution_clock::now() - index_start).count();
+    }
+    uint64_t fingerprint() const { return dataFingerprint(); }
+    void reportField(){
+        cout << "   • Hilos utilizados: " << num_threads << endl;
+        printf("   • Buffers de render: %.1f MB (%zu bytes por vértice)\n", (bufferBytes(particle_render_data) + bufferBytes(star_render_data)) / 1048576.0, vertexBytes());
+        if(visibility_index.built()){
+            printf("   • Índice de visibilidad: %zu cubetas (%d velocidades x %d profundidades) en %.1f ms\n",
+                   visibility_index.bucketCount(), visibility_index.speedBins(), VisibilityIndex::DEPTH_BINS, index_time * 1000.0);
         }
+        if(NUMA_REPORT) printNumaReport();
+    }
+    void beginResize(){
+        pipelineStop();     // el productor lee el SoA
+        old_capacity = pts.capacity;
     }
+    void resizeNote(ostream &out){
+        out << ", capacidad " << pts.capacity << (pts.capacity != old_capacity ? ", buffers reubicados" : "");
+    }
+    void resized(int old_n, int n){
+        if(AUTOTUNE){
+            cout << "Autoajuste: nueva búsqueda para " << n << " partículas" << endl;
+            autotuneRestart();
+        }
+#ifndef SCREENSAVER_NO_GL
+        if(pts.capacity != old_capacity) uploadShaderAttributes();
+        else if(n > old_n) uploadShaderAttributes((size_t)old_n);
+#else
+        (void)old_n;
+#endif
+    }
+    
+    // Frame
+    int count() const { return PARTICLE_COUNT; }
+    int step() const { return PARTICLE_STEP; }
+    int threads() const { return num_threads; }
+    int iterations() const { return MATH_ITERATIONS; }
+    void resizeParticles(int n){ ::resizeParticles(n); }
+    void resetFrameTimers(){ ::resetFrameTimers(); }
+    array<double, 4> stageTotals() const { return ::stageTotals(); }
+    // Del inicio del cálculo del frame a su envío (solo con pipeline); se consume al registrarla
+    double extraLatency(){
+        double latency = pipeline_frame_latency;
+        pipeline_frame_latency = -1.0;
+        return latency;
+    }
+    double headlessFrame(int f){
+        T = beginFrameTime(f, f * headless.dt);
+#ifdef HEADLESS_GL_AVAILABLE
+        if(headless.gl){
+            glClearColor(0.02f,0.02f,0.06f,1.f);
+            glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
+            glLoadIdentity();
+            ::draw();
+            TRACE_SCOPE("glFinish");
+            auto finish_start = chrono::high_resolution_clock::now();
+            glFinish();     // sin swap: se espera a que el rasterizador termine el frame
+            return chrono::duration<double>(chrono::high_resolution_clock::now() - finish_start).count();
+        }
+#endif
+        headless_fb.clear(0.02f,0.02f,0.06f,1.f);
+        headless_fb.setCamera(T);
+        if(SOFT_RASTER) softRasterBegin();
+        ::renderScene();
+        if(SOFT_RASTER) softRasterEnd();
+        return 0.0;
+    }
+    void reportStages(int frames){
+        printHeadlessStage("Estrellas: cálculo", stars_calc_time, frames);
+        printHeadlessStage("Estrellas: envío", stars_draw_time, frames);
+        const bool fused = FUSED_PASSES && !STREAM_PASSES;
+        if(fused) printHeadlessStage("Pases fusionados: cálculo", fused_calc_time, frames);
+        for(int k = 0; k < PASS_COUNT; k++){
+            char stage[64];
+            if(!fused){
+                snprintf(stage, sizeof(stage), "Pase %d: cálculo", k);
+                printHeadlessStage(stage, pass_calc_time[k], frames);
+            }
+            snprintf(stage, sizeof(stage), "Pase %d: envío", k);
+            printHeadlessStage(stage, pass_draw_time[k], frames);
+        }
+        if(SOFT_RASTER) printHeadlessStage("Raster por teselas", raster_time, frames);
+        if(PALETTE_LUT && !pipelineActive()) printHeadlessStage("Paleta: tabla", palette_time, frames);
+    }
+    void reportExtra(){
+        if(index_blocks_total > 0){
+            printf("   • Índice de visibilidad: %.1f%% de los bloques recorridos\n", 100.0 * index_blocks_visited / index_blocks_total);
+        }
+        if(STREAM_PASSES){
+            printf("   • Envío por tramos: %d buffers, %.2f MB (buffer de pases completo: %.1f MB)\n", stream_ring.slots(),
+                   stream_ring.slots() * stream_ring.bufferWords() * sizeof(uint32_t) / 1048576.0,
+                   passStride() * PASS_COUNT * vertexBytes() / 1048576.0);
+        }
+        if(PALETTE_LUT){
+            printf("   • Paleta %dx%d: error máximo %.5f (color en [0, 1], contra colorBH)\n", PALETTE_RES, PALETTE_RES, palette_max_error);
+        }
+    }
+#ifndef SCREENSAVER_NO_GL
+    void beginFrame(int f){ T = beginFrameTime(f, now()); }
+    void draw(){ ::draw(); }
+    void renderScene(){
+        const bool soft = softRasterActive();
+        if(soft) softRasterBegin();
+        ::renderScene();
+        if(soft) softRasterEnd();
+    }
+    void drawHud(){ drawFPS(); }
+    void progress(ostream &out){ out << ", Hilos: " << num_threads; }
+    void quit(){
+        pipelineStop();
+        saveTimingMetrics();
+        traceFinish();
+    }
+#endif
+} app;
+
+// Generación paralela de datos (o mapeo de la caché)
+void gen(int n = -1){
+    generateField(app, session, n == -1 ? PARTICLE_COUNT : n);
+}
+
+// Cambia la cantidad de partículas en caliente: al crecer se generan (en paralelo) solo las nuevas
+// y se agregan al final; al reducir se descartan las últimas (app_shell.h)
+void resizeParticles(int n){
+    resizeField(app, session, PARTICLE_COUNT, n);
+}
+
+#ifndef SCREENSAVER_NO_GL
+// Dibujo de un frame: cámara, estrellas y 6 pases de partículas
+void draw(){
+    drawFrame(app, session, camera, T);
+}
+
+// Callback principal de dibujo de GLUT: mide el tiempo de cada frame
+void display(){
+    displayFrame(app, session);
 }
 
 // Callbacks auxiliares
-void reshape(int w,int h){ W=w; H=h; proj(); }
+void reshape(int w,int h){ W=w; H=h; cameraProjection(W, H); }
 void idle(){ glutPostRedisplay(); }
+#endif
+
+// Modo headless: simula N frames con T fijo y reporta tiempos por etapa. Sin --gl se dibuja
+// en el framebuffer de CPU; con --gl se usa el camino GL normal sobre un contexto sin ventana.
+void runHeadless(){
+#ifdef HEADLESS_GL_AVAILABLE
+    HeadlessGLContext gl_context;
+    if(headless.gl){
+        if(!gl_context.create(W, H)) exit(1);
+        cout << "Contexto GL sin ventana: " << gl_context.renderer() << endl;
+        session.showFPS = false;    // el HUD usa fuentes de GLUT, que no se inicializa
+        cameraProjection(W, H);
+        glEnable(GL_POINT_SMOOTH);
+        if(VBO_RENDER) initVBOs();
+        initShaders();
+    }
+#else
+    if(headless.gl){
+        cerr << "--gl no está disponible en esta plataforma (requiere EGL en Linux)" << endl;
+        exit(1);
+    }
+#endif
+    headless_fb.resize(W, H);
+    gen();
+#ifdef HEADLESS_GL_AVAILABLE
+    if(headless.gl) uploadShaderAttributes();
+#endif
+    
+    // Latencia de cada frame medido y escalones de la rampa (headless.h)
+    HeadlessFrames frame_times(headless);
+    runHeadlessFrames(app, session, headless, frame_times);
+    pipelineStop();
+    reportHeadless(app, session, headless, frame_times, [&]{
+        double checksum;
+#ifdef HEADLESS_GL_AVAILABLE
+        if(headless.gl){
+            checksum = gl_context.checksum();
+            cout << "Checksum del framebuffer (GL): " << checksum << endl;
+            gl_context.destroy();
+            return checksum;
+        }
+#endif
+        checksum = SOFT_RASTER ? soft_raster.checksum() : headless_fb.checksum();
+        cout << "Checksum del framebuffer" << (SOFT_RASTER ? " (teselas)" : "") << ": " << checksum << endl;
+        return checksum;
+    });
+}
 
-// Teclado: ESC guarda métricas; C cambia cámara; F oculta/mostrar FPS; +/- cambia hilos
+#ifndef SCREENSAVER_NO_GL
+// Teclado: ESC guarda métricas; C cambia cámara; F oculta/mostrar FPS; +/- cambia hilos; [ ] cambia partículas;
+// T alterna entre el grafo de tareas y las regiones OpenMP; P activa/desactiva el pipeline de frames;
+// U activa/desactiva el autoajuste (+/- lo desactivan: los hilos pasan a ser manuales);
+// V cambia el formato de vértices; K el recorte por frustum; R el rasterizador por software;
+// I el índice de visibilidad; L la tabla de paleta
 void key(unsigned char k, int x, int y) {
-    float moveSpeed = camera.speed;
+    if(shellKey(app, session, camera, k)) return;
     
     switch(k) {
-        case 27: // ESC
-            saveTimingMetrics();
-            exit(0); 
-            break; 
-        case 'c': case 'C': 
-            camera.freeMode = !camera.freeMode;
-            if (!camera.freeMode) {
-                camera.x = 30.0f; camera.y = 5.0f; camera.z = 0.0f;
-                camera.pitch = 0.0f; camera.yaw = 0.0f;
-            }
-            break;
         case '+': case '=':
+            if(AUTOTUNE){
+                AUTOTUNE = false;
+                cout << "Autoajuste desactivado: hilos manuales" << endl;
+            }
             if(num_threads < omp_get_max_threads()) {
                 num_threads++;
                 cout << "Número de hilos aumentado a: " << num_threads << endl;
             }
             break;
         case '-': case '_':
+            if(AUTOTUNE){
+                AUTOTUNE = false;
+                cout << "Autoajuste desactivado: hilos manuales" << endl;
+            }
             if(num_threads > 1) {
                 num_threads--;
                 cout << "Número de hilos reducido a: " << num_threads << endl;
             }
             break;
-        case 'w': case 'W':
-            if (camera.freeMode) {
-                camera.x += moveSpeed * sinf(camera.yaw * M_PI/180.0f);
-                camera.z -= moveSpeed * cosf(camera.yaw * M_PI/180.0f);
-            }
+        case 't': case 'T':
+            TASK_SCHEDULER = !TASK_SCHEDULER;
+            if(TASK_SCHEDULER) FUSED_PASSES = true;
+            cout << "Planificador: " << (TASK_SCHEDULER ? "grafo de tareas" : "regiones OpenMP") << endl;
             break;
-        case 's': case 'S':
-            if (camera.freeMode) {
-                camera.x -= moveSpeed * sinf(camera.yaw * M_PI/180.0f);
-                camera.z += moveSpeed * cosf(camera.yaw * M_PI/180.0f);
-            }
+        case 'p': case 'P': {
+            static int depth = 2;
+            if(PIPELINE_DEPTH > 1){
+                depth = PIPELINE_DEPTH;
+                PIPELINE_DEPTH = 0;
+            } else PIPELINE_DEPTH = depth;
+            pipelineStop();
+            cout << "Pipeline de frames: " << (PIPELINE_DEPTH ? to_string(PIPELINE_DEPTH) + " juegos de buffers" : string("desactivado")) << endl;
             break;
-        case 'a': case 'A':
-            if (camera.freeMode) {
-                camera.x -= moveSpeed * cosf(camera.yaw * M_PI/180.0f);
-                camera.z -= moveSpeed * sinf(camera.yaw * M_PI/180.0f);
-            }
+        }
+        case 'u': case 'U':
+            AUTOTUNE = !AUTOTUNE;
+            if(AUTOTUNE) autotuneRestart();
+            cout << "Autoajuste de hilos y schedule: " << (AUTOTUNE ? "activado" : "desactivado") << endl;
             break;
-        case 'd': case 'D':
-            if (camera.freeMode) {
-                camera.x += moveSpeed * cosf(camera.yaw * M_PI/180.0f);
-                camera.z += moveSpeed * sinf(camera.yaw * M_PI/180.0f);
-            }
+        case 'v': case 'V':
+            setCompactVertices(!COMPACT_VERTICES);
+            break;
+        case 'k': case 'K':
+            FRUSTUM_CULL = !FRUSTUM_CULL;
+            cout << "Recorte por frustum: " << (FRUSTUM_CULL ? "activado" : "desactivado") << endl;
+            break;
+        case 'r': case 'R':
+            SOFT_RASTER = !SOFT_RASTER;
+            cout << "Rasterizado: " << (SOFT_RASTER ? "por software en teselas (textura)" : "GL") << endl;
             break;
-        case 'q': case 'Q':
-            if (camera.freeMode) camera.y += moveSpeed;
+        case 'i': case 'I':
+            pipelineStop();     // el productor puede estar leyendo la copia del índice
+            VISIBILITY_INDEX = !VISIBILITY_INDEX;
+            buildVisibilityIndex();
+            cout << "Índice de visibilidad: " << (VISIBILITY_INDEX ? "activado" : "desactivado") << endl;
             break;
-        case 'e': case 'E':
-            if (camera.freeMode) camera.y -= moveSpeed;
+        case 'l': case 'L':
+            PALETTE_LUT = !PALETTE_LUT;
+            palette_max_error = 0.0f;
+            cout << "Paleta: " << (PALETTE_LUT ? "tabla " + to_string(PALETTE_RES) + "x" + to_string(PALETTE_RES) : string("colorBH exacto")) << endl;
             break;
-        case 'f': case 'F':
-            showFPS = !showFPS;
+        case 'g': case 'G':
+            if(shader.ready){
+                SHADER_RENDER = !SHADER_RENDER;
+                cout << "Render: " << (SHADER_RENDER ? "vertex shader" : "pre-cálculo OpenMP") << endl;
+            }
             break;
     }
 }
 
 // Mouse y movimiento para mirar en modo cámara libre
 void mouse(int button, int state, int x, int y) {
-    if (button == GLUT_LEFT_BUTTON) {
-        mousePressed = (state == GLUT_DOWN);
-        lastMouseX = x;
-        lastMouseY = y;
-    }
+    if (button == GLUT_LEFT_BUTTON) camera.press(state == GLUT_DOWN, x, y);
 }
 
 void motion(int x, int y) {
-    if (camera.freeMode && mousePressed) {
-        float deltaX = x - lastMouseX;
-        float deltaY = y - lastMouseY;
-        
-        camera.yaw += deltaX * 0.2f;
-        camera.pitch += deltaY * 0.2f;
-        
-        if (camera.pitch > 89.0f) camera.pitch = 89.0f;
-        if (camera.pitch < -89.0f) camera.pitch = -89.0f;
-        
-        lastMouseX = x;
-        lastMouseY = y;
-    }
+    camera.drag(x, y);
 }
+#endif
 
 // Punto de entrada 
 int main(int argc,char**argv){
@@ -592,23 +2260,66 @@ int main(int argc,char**argv){
     cout << "SCREENSAVER PARALELO" << endl;
     cout << "============================================================" << endl;
     
+    // Opciones con nombre (--headless, --frames N, --warmup N, --trace archivo, ...); el resto son argumentos posicionales
+    vector<char*> args;
+    for(int i = 1; i < argc; i++){
+        string opt = argv[i];
+        if(opt == "--headless") headless.enabled = true;
+        else if(opt == "--frames" && i + 1 < argc) headless.frames = max(1, atoi(argv[++i]));
+        else if(opt == "--warmup" && i + 1 < argc) headless.warmup = max(0, atoi(argv[++i]));
+        else if(opt == "--no-save") headless.save_metrics = false;
+        else if(opt == "--trace" && i + 1 < argc){ trace_enabled = true; trace_path = argv[++i]; }
+        else if(opt == "--gl") headless.gl = true;
+        else if(opt == "--no-simd") SIMD_KERNEL = false;
+        else if(opt == "--no-fuse") FUSED_PASSES = false;
+        else if(opt == "--immediate") VBO_RENDER = false;
+        else if(opt == "--shader") SHADER_RENDER = true;
+        else if(opt == "--libm") FAST_MATH = false;
+        else if(opt == "--validate-math") VALIDATE_MATH = true;
+        else if(opt == "--tasks"){ TASK_SCHEDULER = true; FUSED_PASSES = true; }
+        else if(opt == "--star-chunk" && i + 1 < argc) STAR_CHUNK = max(1, atoi(argv[++i]));
+        else if(opt == "--pass-chunk" && i + 1 < argc) PASS_CHUNK = max(1, atoi(argv[++i]));
+        else if(opt == "--cache" && i + 1 < argc){ PARTICLE_CACHE = true; CACHE_DIR = argv[++i]; }
+        else if(opt == "--no-cache") PARTICLE_CACHE = false;
+        else if(opt == "--particle-step" && i + 1 < argc) PARTICLE_STEP = max(1, atoi(argv[++i]));
+        else if(opt == "--ramp" && i + 1 < argc) headless.ramp = max(1, atoi(argv[++i]));
+        else if(opt == "--autotune") AUTOTUNE = true;
+        else if(opt == "--compact") COMPACT_VERTICES = true;
+        else if(opt == "--no-cull") FRUSTUM_CULL = false;
+        else if(opt == "--raster") SOFT_RASTER = true;
+        else if(opt == "--index") VISIBILITY_INDEX = true;
+        else if(opt == "--no-index") VISIBILITY_INDEX = false;
+        else if(opt == "--palette" && i + 1 < argc){ PALETTE_LUT = true; PALETTE_RES = max(2, atoi(argv[++i])); }
+        else if(opt == "--stream"){ STREAM_PASSES = true; FUSED_PASSES = false; }
+        else if(opt == "--stream-chunk" && i + 1 < argc) STREAM_CHUNK = max(1, atoi(argv[++i]));
+        else if(opt == "--affinity" && i + 1 < argc){
+            string mode = argv[++i];
+            if(mode == "compact") THREAD_AFFINITY = AFFINITY_COMPACT;
+            else if(mode == "spread") THREAD_AFFINITY = AFFINITY_SPREAD;
+            else cerr << "--affinity: se espera compact o spread (se ignora '" << mode << "')" << endl;
+        }
+        else if(opt == "--numa-report") NUMA_REPORT = true;
+        else if(opt == "--pipeline" && i + 1 < argc){ PIPELINE_DEPTH = max(2, min(3, atoi(argv[++i]))); FUSED_PASSES = true; }
+        else args.push_back(argv[i]);
+    }
+    
     // Lectura de argumentos: partículas, iteraciones y número de hilos
-    if(argc > 1) {
-        PARTICLE_COUNT = atoi(argv[1]);
-        if(PARTICLE_COUNT < 10000) PARTICLE_COUNT = 10000;
-        if(PARTICLE_COUNT > 1000000) PARTICLE_COUNT = 1000000;
+    if(args.size() > 0) {
+        PARTICLE_COUNT = atoi(args[0]);
+        if(PARTICLE_COUNT < PARTICLE_MIN) PARTICLE_COUNT = PARTICLE_MIN;
+        if(PARTICLE_COUNT > PARTICLE_MAX) PARTICLE_COUNT = PARTICLE_MAX;
         cout << "• Partículas configuradas por argumento: " << PARTICLE_COUNT << endl;
     }
     
-    if(argc > 2) {
-        MATH_ITERATIONS = atoi(argv[2]);
+    if(args.size() > 1) {
+        MATH_ITERATIONS = atoi(args[1]);
         if(MATH_ITERATIONS < 1) MATH_ITERATIONS = 1;
         if(MATH_ITERATIONS > 50) MATH_ITERATIONS = 50;
         cout << "• Iteraciones matemáticas configuradas: " << MATH_ITERATIONS << endl;
     }
     
-    if(argc > 3) {
-        num_threads = atoi(argv[3]);
+    if(args.size() > 2) {
+        num_threads = atoi(args[2]);
         if(num_threads < 1) num_threads = 1;
         if(num_threads > omp_get_max_threads()) num_threads = omp_get_max_threads();
         cout << "• Hilos configurados por argumento: " << num_threads << endl;
@@ -622,19 +2333,64 @@ int main(int argc,char**argv){
     cout << "   • Carga computacional estimada: " << (PARTICLE_COUNT * MATH_ITERATIONS * 10) << " ops/frame" << endl;
     cout << "   • Hilos OpenMP: " << num_threads << " de " << omp_get_max_threads() << " disponibles" << endl;
     cout << "   • Versión: PARALELA" << endl;
-    cout << "   • Passes de renderizado: 6" << endl;
+    cout << "   • Carga matemática de gen(): " << (!HEAVY_MATH_MODE ? "desactivada" : FAST_MATH ? "SIMD " SIMD_NAME " (polinomios)" : "libm escalar") << endl;
+    cout << "   • Kernel de pases: " << (SIMD_KERNEL ? SIMD_NAME : "escalar") << " (" << (SIMD_KERNEL ? SIMD_WIDTH : 1) << " partículas/instrucción)" << endl;
+    if(SOFT_RASTER) cout << "   • Rasterizado: por software, teselas de " << TileRasterizer::TILE << "x" << TileRasterizer::TILE << " acumuladas en paralelo y presentadas como textura" << endl;
+    cout << "   • Envío a GL: " << (SHADER_RENDER ? "vertex shader (atributos estáticos)" : VBO_RENDER ? "VBO (un glDrawArrays por pase)" : "modo inmediato (glBegin/glEnd)") << endl;
+    cout << "   • Formato de vértices: " << (COMPACT_VERTICES ? "compacto (posición int16, color RGBA8, 12 bytes)" : "float completo (32 bytes)") << endl;
+    cout << "   • Recorte por frustum: " << (FRUSTUM_CULL ? to_string(CULL_SLABS) + " rebanadas de profundidad + anillo por partícula" : string("desactivado")) << endl;
+    cout << "   • Índice de visibilidad: " << (!VISIBILITY_INDEX ? "desactivado" : FUSED_PASSES && !STREAM_PASSES ? "sin efecto con los pases fusionados (usar --no-fuse o --stream)" : "cubetas por velocidad y profundidad inicial, descarte por frame y pase") << endl;
+    cout << "   • Paleta de los pases: " << (PALETTE_LUT ? "tabla bilineal de " + to_string(PALETTE_RES) + "x" + to_string(PALETTE_RES) + " por frame" : string("colorBH exacto")) << endl;
+    cout << "   • Passes de renderizado: " << PASS_COUNT << (FUSED_PASSES ? " (fusionados en un barrido)" : "") << endl;
+    if(STREAM_PASSES) cout << "   • Envío por tramos: " << STREAM_CHUNK << " partículas por tramo, anillo de " << max(1, 2 * (num_threads - 1)) << " buffers (el cálculo se solapa con el envío; sin pipeline ni tareas)" << endl;
+    if(TASK_SCHEDULER && !STREAM_PASSES) cout << "   • Planificador del frame: grafo de tareas con robo de trabajo (tramos: " << STAR_CHUNK << " estrellas, " << PASS_CHUNK << " partículas)" << endl;
+    else cout << "   • Planificador del frame: regiones paralelas OpenMP" << endl;
+    if(AUTOTUNE){
+        autotuneRestart();
+        cout << "   • Autoajuste por etapa: hasta " << omp_get_max_threads() << " hilos, schedule y chunk (" << StageTuner::SAMPLES << " frames por configuración)" << endl;
+    }
+    if(PIPELINE_DEPTH && !STREAM_PASSES) cout << "   • Pipeline de frames: " << PIPELINE_DEPTH << " juegos de buffers (el cálculo del frame siguiente se solapa con el envío)" << endl;
+    cout << "   • Caché del campo generado: " << (PARTICLE_CACHE ? CACHE_DIR + "/ (mmap)" : string("desactivada")) << endl;
+    cout << "   • Cambio de partículas en caliente: [ / ] de a " << PARTICLE_STEP << endl;
+    if(headless.ramp > 0) cout << "   • Rampa headless: +" << PARTICLE_STEP << " partículas cada " << headless.ramp << " frames" << endl;
+    cout << "   • NUMA: " << numaNodeCount() << " nodo(s), primer toque paralelo de los buffers | hilos " << affinityName(THREAD_AFFINITY) << endl;
+    if(trace_enabled) cout << "   • Traza (Chrome trace-event): " << trace_path << endl;
     cout << endl;
+    
+    // Los hilos se fijan antes de generar: el primer toque de los buffers depende de dónde corren
+    if(THREAD_AFFINITY != AFFINITY_NONE && !pinOpenMPThreads(THREAD_AFFINITY, omp_get_max_threads())){
+        cerr << "No se pudo fijar la afinidad de los hilos (" << affinityName(THREAD_AFFINITY) << "); se continúa sin fijar" << endl;
+    }
     cout << "Iniciando medición de tiempo" << endl;
     
-    start_time = chrono::high_resolution_clock::now();
+    session.start_time = chrono::high_resolution_clock::now();
+    
+#ifdef SCREENSAVER_NO_GL
+    // Compilación sin GL: siempre headless sobre el framebuffer de CPU
+    headless.enabled = true;
+    headless.gl = false;
+#endif
+    
+    // Sin ventana: simula los frames pedidos, guarda métricas y termina
+    if(headless.enabled) {
+        cout << "Modo headless: " << headless.frames << " frames sin GLUT" << endl;
+        runHeadless();
+        if(headless.save_metrics) saveTimingMetrics();
+        traceFinish();
+        return 0;
+    }
     
+#ifndef SCREENSAVER_NO_GL
     // Inicialización de GLUT y registro de callbacks
     glutInit(&argc,argv);
     glutInitDisplayMode(GLUT_DOUBLE|GLUT_RGB|GLUT_DEPTH);
     glutInitWindowSize(W,H);
     glutCreateWindow("Agujero de gusano");
-    proj(); 
+    cameraProjection(W, H); 
+    if(VBO_RENDER) initVBOs();
+    initShaders();
     gen();  // generación paralela de datos
+    uploadShaderAttributes();
     glEnable(GL_POINT_SMOOTH);
     glutDisplayFunc(display);
     glutReshapeFunc(reshape);
@@ -643,5 +2399,6 @@ int main(int argc,char**argv){
     glutMouseFunc(mouse);
     glutMotionFunc(motion);
     glutMainLoop();
+#endif
     return 0;
 }
\ No newline at end of file
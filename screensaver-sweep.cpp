@@ -0,0 +1,263 @@
+// Barrido de benchmarks: ejecuta screensaver-seq-bench y screensaver-bench (modo headless) sobre
+// una grilla de partículas x iteraciones x hilos, con calentamiento y repeticiones, y calcula
+// mediana/p95/p99 por frame, speedup y eficiencia respecto a la versión secuencial.
+// Cada repetición es un proceso nuevo; de cada uno se lee la línea "BENCH ..." (ver headless.h).
+// La huella de los datos generados debe ser la misma en ambas versiones y con cualquier número de
+// hilos: si difiere (p. ej. el compilador armó distinto la carga SIMD en un build nativo) el barrido
+// termina con error.
+//
+// Uso: screensaver-sweep [--particles 100000,200000] [--iterations 5,15] [--threads 1,2,4]
+//                        [--frames 120] [--warmup 20] [--reps 5] [--weak] [--check]
+//                        [--seq RUTA] [--par RUTA] [--csv archivo.csv] [--json archivo.json]
+// --weak escala las partículas con los hilos (N * hilos) para curvas de escalado débil.
+// --check solo valida las huellas: un frame, sin calentamiento ni repeticiones.
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <tuple>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+#ifndef SWEEP_SEQ_BENCH
+#define SWEEP_SEQ_BENCH "./screensaver-seq-bench"
+#endif
+#ifndef SWEEP_PAR_BENCH
+#define SWEEP_PAR_BENCH "./screensaver-bench"
+#endif
+
+// Parámetros del barrido
+struct SweepConfig {
+    vector<int> particles = {100000, 200000, 400000};
+    vector<int> iterations = {5, 15};
+    vector<int> threads;            // por defecto: potencias de 2 hasta los núcleos disponibles
+    int frames = 120;
+    int warmup = 20;
+    int reps = 5;
+    bool weak = false;
+    string seq_path = SWEEP_SEQ_BENCH;
+    string par_path = SWEEP_PAR_BENCH;
+    string csv_path, json_path;
+} cfg;
+
+// Estadísticas de una configuración, agregadas sobre las repeticiones (mediana de cada métrica)
+struct SweepResult {
+    string version;
+    int particles = 0, iterations = 0, threads = 0, frames = 0;
+    double mean_ms = 0, p50_ms = 0, p95_ms = 0, p99_ms = 0, max_ms = 0;
+    double p50_min_ms = 0, p50_max_ms = 0;   // dispersión de la mediana entre repeticiones
+    double speedup = 0, efficiency = 0;
+    double checksum = 0;
+    string fingerprint;             // huella de los datos generados (hex)
+};
+
+vector<int> parseList(const string &s){
+    vector<int> out;
+    stringstream ss(s);
+    string item;
+    while(getline(ss, item, ',')) if(!item.empty()) out.push_back(atoi(item.c_str()));
+    return out;
+}
+
+double median(vector<double> v){
+    if(v.empty()) return 0.0;
+    sort(v.begin(), v.end());
+    size_t m = v.size() / 2;
+    return v.size() % 2 ? v[m] : 0.5 * (v[m - 1] + v[m]);
+}
+
+// Ejecuta un benchmark y devuelve los campos de su línea BENCH (vacío si falló)
+map<string, string> runOnce(const string &cmd){
+    map<string, string> fields;
+    FILE *pipe = popen(cmd.c_str(), "r");
+    if(!pipe) return fields;
+    char line[1024];
+    while(fgets(line, sizeof(line), pipe)){
+        if(string(line).rfind("BENCH ", 0) != 0) continue;
+        stringstream ss(line + 6);
+        string kv;
+        while(ss >> kv){
+            size_t eq = kv.find('=');
+            if(eq != string::npos) fields[kv.substr(0, eq)] = kv.substr(eq + 1);
+        }
+    }
+    if(pclose(pipe) != 0) fields.clear();
+    return fields;
+}
+
+// Repite una configuración cfg.reps veces y agrega los resultados
+SweepResult runConfig(const string &binary, bool parallel, int particles, int iterations, int threads){
+    string cmd = "\"" + binary + "\" --no-save --frames " + to_string(cfg.frames) +
+                 " --warmup " + to_string(cfg.warmup) + " " + to_string(particles) + " " + to_string(iterations);
+    if(parallel) cmd += " " + to_string(threads);
+    cmd += " 2>&1";
+
+    vector<double> mean, p50, p95, p99, mx;
+    SweepResult r;
+    for(int rep = 0; rep < cfg.reps; rep++){
+        map<string, string> f = runOnce(cmd);
+        if(f.empty()){
+            cerr << "Error: no se obtuvo la línea BENCH de: " << cmd << endl;
+            exit(1);
+        }
+        mean.push_back(atof(f["mean_ms"].c_str()));
+        p50.push_back(atof(f["p50_ms"].c_str()));
+        p95.push_back(atof(f["p95_ms"].c_str()));
+        p99.push_back(atof(f["p99_ms"].c_str()));
+        mx.push_back(atof(f["max_ms"].c_str()));
+        // Los valores efectivos los reporta el programa (aplica sus propios límites)
+        r.version = f["version"];
+        r.particles = atoi(f["particles"].c_str());
+        r.iterations = atoi(f["iterations"].c_str());
+        r.threads = atoi(f["threads"].c_str());
+        r.frames = atoi(f["frames"].c_str());
+        r.checksum = atof(f["checksum"].c_str());
+        if(!r.fingerprint.empty() && f["fingerprint"] != r.fingerprint){
+            cerr << "Error: la huella de datos cambió entre repeticiones de: " << cmd << endl;
+            exit(1);
+        }
+        r.fingerprint = f["fingerprint"];
+    }
+    r.mean_ms = median(mean);
+    r.p50_ms = median(p50);
+    r.p95_ms = median(p95);
+    r.p99_ms = median(p99);
+    r.max_ms = median(mx);
+    r.p50_min_ms = *min_element(p50.begin(), p50.end());
+    r.p50_max_ms = *max_element(p50.begin(), p50.end());
+    return r;
+}
+
+void writeCSV(const vector<SweepResult> &results){
+    ofstream f(cfg.csv_path);
+    f << "version,particles,iterations,threads,reps,frames,mean_ms,p50_ms,p95_ms,p99_ms,max_ms,"
+         "p50_min_ms,p50_max_ms,speedup,efficiency,checksum,fingerprint\n";
+    for(const SweepResult &r : results){
+        f << r.version << "," << r.particles << "," << r.iterations << "," << r.threads << ","
+          << cfg.reps << "," << r.frames << "," << r.mean_ms << "," << r.p50_ms << "," << r.p95_ms << ","
+          << r.p99_ms << "," << r.max_ms << "," << r.p50_min_ms << "," << r.p50_max_ms << ","
+          << r.speedup << "," << r.efficiency << "," << fixed << r.checksum << defaultfloat << "," << r.fingerprint << "\n";
+    }
+}
+
+void writeJSON(const vector<SweepResult> &results){
+    ofstream f(cfg.json_path);
+    f << "{\n  \"config\": {\"frames\": " << cfg.frames << ", \"warmup\": " << cfg.warmup
+      << ", \"reps\": " << cfg.reps << ", \"scaling\": \"" << (cfg.weak ? "weak" : "strong") << "\"},\n";
+    f << "  \"results\": [\n";
+    for(size_t i = 0; i < results.size(); i++){
+        const SweepResult &r = results[i];
+        f << "    {\"version\": \"" << r.version << "\", \"particles\": " << r.particles
+          << ", \"iterations\": " << r.iterations << ", \"threads\": " << r.threads
+          << ", \"frames\": " << r.frames << ", \"mean_ms\": " << r.mean_ms << ", \"p50_ms\": " << r.p50_ms
+          << ", \"p95_ms\": " << r.p95_ms << ", \"p99_ms\": " << r.p99_ms << ", \"max_ms\": " << r.max_ms
+          << ", \"p50_min_ms\": " << r.p50_min_ms << ", \"p50_max_ms\": " << r.p50_max_ms
+          << ", \"speedup\": " << r.speedup << ", \"efficiency\": " << r.efficiency
+          << ", \"checksum\": " << fixed << r.checksum << defaultfloat << ", \"fingerprint\": \"" << r.fingerprint << "\"}"
+          << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    f << "  ]\n}\n";
+}
+
+int main(int argc, char **argv){
+    for(int i = 1; i < argc; i++){
+        string opt = argv[i];
+        bool has_value = i + 1 < argc;
+        if(opt == "--particles" && has_value) cfg.particles = parseList(argv[++i]);
+        else if(opt == "--iterations" && has_value) cfg.iterations = parseList(argv[++i]);
+        else if(opt == "--threads" && has_value) cfg.threads = parseList(argv[++i]);
+        else if(opt == "--frames" && has_value) cfg.frames = max(1, atoi(argv[++i]));
+        else if(opt == "--warmup" && has_value) cfg.warmup = max(0, atoi(argv[++i]));
+        else if(opt == "--reps" && has_value) cfg.reps = max(1, atoi(argv[++i]));
+        else if(opt == "--weak") cfg.weak = true;
+        else if(opt == "--check"){ cfg.frames = 1; cfg.warmup = 0; cfg.reps = 1; }
+        else if(opt == "--seq" && has_value) cfg.seq_path = argv[++i];
+        else if(opt == "--par" && has_value) cfg.par_path = argv[++i];
+        else if(opt == "--csv" && has_value) cfg.csv_path = argv[++i];
+        else if(opt == "--json" && has_value) cfg.json_path = argv[++i];
+        else {
+            cerr << "Opción desconocida: " << opt << endl;
+            return 1;
+        }
+    }
+    if(cfg.threads.empty()){
+        int cores = max(1u, thread::hardware_concurrency());
+        for(int t = 1; t < cores; t *= 2) cfg.threads.push_back(t);
+        cfg.threads.push_back(cores);
+    }
+
+    cout << "BARRIDO DE BENCHMARKS (" << (cfg.weak ? "escalado débil" : "escalado fuerte") << ")" << endl;
+    cout << "   • Frames: " << cfg.frames << " (+" << cfg.warmup << " de calentamiento) x "
+         << cfg.reps << " repeticiones por configuración" << endl;
+    cout << "   • Secuencial: " << cfg.seq_path << endl;
+    cout << "   • Paralelo: " << cfg.par_path << endl << endl;
+    printf("%-10s %9s %5s %5s %10s %10s %10s %10s %8s %8s\n",
+           "versión", "partíc.", "iter", "hilos", "p50 ms", "p95 ms", "p99 ms", "máx ms", "speedup", "efic.");
+
+    vector<SweepResult> results;
+    map<pair<int, int>, double> seq_p50;     // línea base por (partículas, iteraciones)
+    map<pair<int, int>, string> seq_fingerprint;
+    int mismatches = 0;
+    set<tuple<int, int, int>> measured;       // (partículas, iteraciones, hilos) ya reportados
+    auto report = [&](const SweepResult &r){
+        printf("%-10s %9d %5d %5d %10.3f %10.3f %10.3f %10.3f %8.2f %8.2f\n",
+               r.version.c_str(), r.particles, r.iterations, r.threads,
+               r.p50_ms, r.p95_ms, r.p99_ms, r.max_ms, r.speedup, r.efficiency);
+        fflush(stdout);
+        results.push_back(r);
+    };
+
+    for(int iterations : cfg.iterations){
+        for(int particles : cfg.particles){
+            for(int threads : cfg.threads){
+                int n = cfg.weak ? particles * threads : particles;
+                SweepResult par = runConfig(cfg.par_path, true, n, iterations, threads);
+                // El programa limita los hilos a los disponibles: no repetir filas idénticas
+                if(!measured.insert(make_tuple(par.particles, par.iterations, par.threads)).second){
+                    cerr << "Aviso: " << threads << " hilos se limitaron a " << par.threads << "; se omite" << endl;
+                    continue;
+                }
+                // La línea base secuencial se mide una vez por tamaño efectivo
+                pair<int, int> key(par.particles, par.iterations);
+                if(!seq_p50.count(key)){
+                    SweepResult seq = runConfig(cfg.seq_path, false, n, iterations, 1);
+                    seq.speedup = seq.efficiency = 1.0;
+                    seq_p50[key] = seq.p50_ms;
+                    seq_fingerprint[key] = seq.fingerprint;
+                    report(seq);
+                }
+                if(par.fingerprint != seq_fingerprint[key]){
+                    cerr << "Error: huella de datos distinta con " << par.particles << " partículas, " << par.iterations
+                         << " iteraciones, " << par.threads << " hilos: secuencial " << seq_fingerprint[key]
+                         << ", paralelo " << par.fingerprint << endl;
+                    mismatches++;
+                }
+                par.speedup = par.p50_ms > 0 ? seq_p50[key] / par.p50_ms : 0.0;
+                par.efficiency = par.speedup / par.threads;
+                report(par);
+            }
+        }
+    }
+
+    if(!cfg.csv_path.empty()){
+        writeCSV(results);
+        cout << "CSV escrito en " << cfg.csv_path << endl;
+    }
+    if(!cfg.json_path.empty()){
+        writeJSON(results);
+        cout << "JSON escrito en " << cfg.json_path << endl;
+    }
+    if(mismatches > 0){
+        cerr << mismatches << " configuración(es) con huellas de datos distintas entre versiones" << endl;
+        return 1;
+    }
+    cout << "Huellas de datos: iguales en todas las configuraciones" << endl;
+    return 0;
+}
@@ -1,13 +1,33 @@
 #define GL_SILENCE_DEPRECATION
+// SCREENSAVER_NO_GL: compilación solo headless (framebuffer de CPU), sin GL ni GLUT
+#ifndef SCREENSAVER_NO_GL
+#ifdef __APPLE__
 #include <OpenGL/gl.h>
 #include <OpenGL/glu.h>
 #include <GLUT/glut.h>
+#else
+#include <GL/gl.h>
+#include <GL/glu.h>
+#include <GL/glut.h>
+#endif
+#endif
 #include <vector>
-#include <random>
 #include <chrono>
 #include <cmath>
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <algorithm>
+#include <array>
+#include "headless.h"
+#include "heavy_math.h"
+#include "counter_rng.h"
+#include "particle_cache.h"
+#include "trace.h"
+#include "latency.h"
+#include "pass_engine.h"
+#include "particle_field.h"
+#include "app_shell.h"
 
 using namespace std;
 
@@ -21,445 +41,402 @@ int PARTICLE_COUNT = 200000;    // Cantidad de partículas
 int STAR_COUNT = 15000;         // Cantidad de estrellas
 int MATH_ITERATIONS = 15;       // Número de iteraciones matemáticas por partícula  
 bool HEAVY_MATH_MODE = true;    // Activa cálculos adicionales para simular carga 
+bool FAST_MATH = true;          // Carga matemática con funciones SIMD (--libm: sinf/powf/... escalares)
+bool VALIDATE_MATH = false;     // --validate-math: compara la carga SIMD contra libm al generar
+bool PARTICLE_CACHE = true;     // Guarda/carga el campo generado en CACHE_DIR (--no-cache lo desactiva)
+string CACHE_DIR = "cache_particulas";     // --cache DIR (mismo formato que la versión paralela)
 
 // Variables para medir tiempos
-chrono::high_resolution_clock::time_point start_time;
-chrono::high_resolution_clock::time_point frame_start;
-chrono::high_resolution_clock::time_point frame_end;
-double total_gen_time = 0.0;
-double total_draw_time = 0.0;
-double total_computation_time = 0.0;
-int frame_count_timing = 0;
-bool timing_enabled = true;
-
-// Estructura para la cámara
-struct Camera {
-    float x, y, z;          
-    float pitch, yaw;       
-    float speed;            
-    bool freeMode;          
-} camera = {30.0f, 5.0f, 0.0f, 0.0f, 0.0f, 2.0f, false};
-
-// Variables para controlar el mouse y el modo de cámara
-int lastMouseX = W/2, lastMouseY = H/2;
-bool mousePressed = false;
-
-// Variables para mostrar FPS en pantalla
-bool showFPS = true;
-int frameCount = 0;
-float lastTime = 0.0f;
-float currentFPS = 0.0f;
-
-// Definición de partícula y contenedores
-struct Particle{float a,z,r,spd,band,jx,jy;};
+
+// Medición de la sesión (frame_session.h): tiempos acumulados, latencias por frame y etapa y FPS
+// del HUD. Etapas del histograma (cálculo y envío van juntos en la versión secuencial):
+enum { LAT_FRAME, LAT_STARS, LAT_PASSES, LAT_SWAP };
+FrameSession session{"Frame", "Estrellas", "Pases", "Swap"};
+
+// Tiempos por etapa acumulados por sesión
+double stars_time = 0.0;
+double pass_time[PASS_COUNT] = {0};
+
+// Modo headless: sin ventana, dibuja en un framebuffer de CPU
+HeadlessConfig headless;
+HeadlessFramebuffer headless_fb;
+
+// Cámara orbital o libre y estado del mouse (camera.h)
+Camera camera;
+
+// Contenedores de partículas (la partícula y la tabla de pases están en pass_engine.h)
 vector<Particle> pts,stars;
 
-// Función de tiempo relativo
-float now(){ 
-    static auto t0=chrono::high_resolution_clock::now(); 
-    auto t=chrono::high_resolution_clock::now(); 
-    return chrono::duration<float>(t-t0).count(); 
+// Reinicia los acumuladores por frame (al terminar el calentamiento del modo headless)
+void resetFrameTimers(){
+    session.resetFrames();
+    stars_time = 0.0;
+    for(int k = 0; k < PASS_COUNT; k++) pass_time[k] = 0.0;
+}
+
+// Acumulados por etapa (estrellas y pases); la diferencia entre el inicio y el fin de un frame
+// da el tiempo de cada etapa en ese frame
+array<double, 2> stageTotals(){
+    array<double, 2> t = {stars_time, 0.0};
+    for(int k = 0; k < PASS_COUNT; k++) t[1] += pass_time[k];
+    return t;
 }
 
 // Guarda métricas de ejecución en un archivo
 void saveTimingMetrics() {
-    if (frame_count_timing > 0) {
-        ofstream file("sequential_timing_results.txt", ios::app);
-        file << "=== MÉTRICAS SECUENCIALES ===" << endl;
-        file << "Partículas procesadas: " << PARTICLE_COUNT << endl;
-        file << "Iteraciones matemáticas por partícula: " << MATH_ITERATIONS << endl;
-        file << "Estrellas: " << STAR_COUNT << endl;
-        file << "Frames procesados: " << frame_count_timing << endl;
-        file << "Tiempo de generación por frame: " << (total_gen_time / frame_count_timing) * 1000 << " ms" << endl;
-        file << "Tiempo de renderizado por frame: " << (total_draw_time / frame_count_timing) * 1000 << " ms" << endl;
-        file << "Tiempo total de computación: " << total_computation_time << " segundos" << endl;
-        file << "Tiempo por frame: " << (total_computation_time / frame_count_timing) * 1000 << " ms" << endl;
-        file << "FPS basado en cálculos: " << frame_count_timing / total_computation_time << endl;
-        file << "Operaciones matemáticas estimadas por frame: " << (PARTICLE_COUNT * MATH_ITERATIONS * 10) << endl;
-        file << "================================" << endl << endl;
-        file.close();
-        
-        cout << "\n=== MÉTRICAS SECUENCIALES FINALES ===" << endl;
-        cout << "Partículas: " << PARTICLE_COUNT << " | Iteraciones: " << MATH_ITERATIONS << endl;
-        cout << "Frames procesados: " << frame_count_timing << endl;
-        cout << "Tiempo total de computación: " << total_computation_time << " segundos" << endl;
-        cout << "Tiempo por frame: " << (total_computation_time / frame_count_timing) * 1000 << " ms" << endl;
-        cout << "FPS: " << frame_count_timing / total_computation_time << endl;
-        cout << "=====================================" << endl;
-    }
+    session.saveMetrics({"sequential_timing_results.txt", "=== MÉTRICAS SECUENCIALES ===", "=== MÉTRICAS SECUENCIALES FINALES ==="},
+                        PARTICLE_COUNT, MATH_ITERATIONS, STAR_COUNT, [](ostream &){}, [](ostream &){});
 }
 
-// Genera partículas y estrellas (cálculo secuencial)
-void gen(int n = -1){
-    if(n == -1) n = PARTICLE_COUNT;
-    
-    auto gen_start = chrono::high_resolution_clock::now();
-    
-    cout << "Generando " << n << " partículas SECUENCIAL" << endl;
-    
-    pts.resize(n);
-    std::mt19937 rng(1337);
-    std::uniform_real_distribution<float> U(0.f,1.f),S(-1.f,1.f);
-    
-    
-    for(int i = 0; i < n; i++){
-        // Se inicializan atributos de cada partícula
-        pts[i].a=6.2831853f*U(rng);
-        pts[i].z=-1200.f*U(rng)-40.f;
-        pts[i].r=4.f+26.f*powf(U(rng),0.7f);
-        pts[i].spd=18.f+48.f*U(rng);
-        pts[i].band=floorf(U(rng)*7.f);
-        pts[i].jx=0.6f*S(rng);
-        pts[i].jy=0.6f*S(rng);
+// Huella de los datos generados: igual en la versión secuencial y la paralela con cualquier número de hilos
+uint64_t dataFingerprint(){
+    return fieldFingerprint(pts.size(), [](size_t i){ return pts[i]; }, stars);
+}
+
+// Paso de los cambios de cantidad de partículas (teclas [ ] y --ramp; límites en particle_field.h)
+int PARTICLE_STEP = 50000;      // --particle-step N
+
+// Genera las partículas [i0, i1) de pts ya dimensionado. Cada partícula depende solo de su índice,
+// así que generar por tramos da los mismos datos que generar todo de una vez.
+// Si se valida, devuelve en initial las partículas previas a la carga SIMD.
+void generateParticles(int i0, int i1, vector<Particle> &initial){
+    for(int i = i0; i < i1; i++){
+        // Se inicializan atributos de cada partícula (particle_field.h: igual que la versión paralela)
+        pts[i] = initialParticle(i);
         
-        // Cálculo extra para simular carga
-        if(HEAVY_MATH_MODE) {
-            for(int iter = 0; iter < MATH_ITERATIONS; iter++) {
-                
-                float complexity_factor = 1.0f + iter * 0.1f;
-                float dummy = 0;
-                 
-                dummy += sinf(pts[i].a * complexity_factor) * cosf(pts[i].z * complexity_factor);
-                dummy += tanf(pts[i].r * 0.01f + iter) * sinf(pts[i].spd * 0.001f);
-                dummy += sqrtf(fabsf(pts[i].r * complexity_factor + 1));
-                dummy += powf(fabsf(pts[i].spd), 1.2f + 0.05f * iter);
-                dummy += expf(-fabsf(pts[i].jx) * 0.1f) * logf(fabsf(pts[i].jy) + 1.0f);
-                dummy += atanf(pts[i].band + iter) * sinhf(pts[i].a * 0.1f);
-                
-                for(int j = 0; j < 3; j++) {
-                    dummy += cosf(pts[i].a + j) * sinf(pts[i].z + j);
-                }
-                
-                pts[i].a += dummy * 0.0001f;
-                pts[i].jx += dummy * 0.00005f;
-            }
+        // Cálculo extra para simular carga (referencia libm)
+        if(HEAVY_MATH_MODE && !FAST_MATH) {
+            Particle &p = pts[i];
+            heavyMathScalar(p.a, p.jx, p.z, p.r, p.spd, p.band, p.jy, MATH_ITERATIONS);
         }
          
-        if((i + 1) % 50000 == 0) {
-            cout << "  Progreso: " << (i + 1) << "/" << n << " partículas..." << endl;
+        if((i + 1 - i0) % 50000 == 0) {
+            cout << "  Progreso: " << (i + 1 - i0) << "/" << (i1 - i0) << " partículas..." << endl;
         }
     }
     
-    // Generación de estrellas
-    int m = STAR_COUNT;
-    stars.resize(m);
-    for(int i=0;i<m;i++){
-        float a=6.2831853f*U(rng);
-        float R=140.f*sqrtf(U(rng));
-        stars[i]={a,-4000.f*U(rng)-200.f,R*cosf(a),10.f+R*sinf(a),14.f+20.f*U(rng),0.f,0.f};
-        
-        
-        if(HEAVY_MATH_MODE) {
-            for(int iter = 0; iter < 5; iter++) {
-                float dummy = sinf(a * iter) + cosf(R * iter) + tanf(stars[i].spd * 0.01f);
-                stars[i].a += dummy * 0.0001f;
+    // Carga matemática vectorial: SIMD_WIDTH partículas a la vez (copias iniciales solo si se valida)
+    if(HEAVY_MATH_MODE && FAST_MATH) {
+        if(VALIDATE_MATH) initial.assign(pts.begin() + i0, pts.begin() + i1);
+        TRACE_SCOPE("gen: carga SIMD");
+        for(int j = i0; j < i1; j += SIMD_WIDTH){
+            int count = min(SIMD_WIDTH, i1 - j);
+            float a[SIMD_WIDTH], z[SIMD_WIDTH], r[SIMD_WIDTH], spd[SIMD_WIDTH];
+            float band[SIMD_WIDTH], jx[SIMD_WIDTH], jy[SIMD_WIDTH];
+            for(int l = 0; l < count; l++){
+                const Particle &p = pts[j + l];
+                a[l] = p.a; z[l] = p.z; r[l] = p.r; spd[l] = p.spd; band[l] = p.band; jx[l] = p.jx; jy[l] = p.jy;
             }
+            heavyMathBlock(a, jx, z, r, spd, band, jy, count, MATH_ITERATIONS);
+            for(int l = 0; l < count; l++){ pts[j + l].a = a[l]; pts[j + l].jx = jx[l]; }
         }
     }
-    
-    auto gen_end = chrono::high_resolution_clock::now();
-    double gen_time = chrono::duration<double>(gen_end - gen_start).count();
-    
-    if (timing_enabled) {
-        total_gen_time += gen_time;
-    }
-    
-    cout << "Generación SECUENCIAL completada en " << gen_time << " segundos" << endl;
-    cout << "   • Partículas: " << n << " con " << MATH_ITERATIONS << " iteraciones cada una" << endl;
-    cout << "   • Estrellas: " << m << endl;
-    cout << "   • Operaciones matemáticas: ~" << (n * MATH_ITERATIONS * 10) << " por frame" << endl;
-    cout << endl;
 }
 
-// Configuración de la proyección
-void proj(){
-    glViewport(0,0,W,H);
-    glMatrixMode(GL_PROJECTION); glLoadIdentity();
-    gluPerspective(72.0,(double)W/(double)H,0.1,6000.0);
-    glMatrixMode(GL_MODELVIEW);
+// Compara contra libm las partículas [i0, i0 + initial.size()) (fuera del tiempo medido)
+void validateParticles(int i0, const vector<Particle> &initial){
+    if(initial.empty()) return;
+    HeavyMathCheck check;
+    for(size_t k = 0; k < initial.size(); k++){
+        const Particle &p = initial[k];
+        const Particle &q = pts[i0 + k];
+        check.check(p.a, p.jx, p.z, p.r, p.spd, p.band, p.jy, MATH_ITERATIONS, q.a, q.jx);
+    }
+    check.print();
 }
 
-// Control de la cámara (orbital o libre)
-void camera_control(){
-    if (!camera.freeMode) {
-        float r=28.f+7.f*sinf(0.32f*T);
-        float a=0.3f*T;
-        float h=3.8f+2.8f*sinf(0.21f*T+0.9f);
-        gluLookAt(r*cosf(a),h,r*sinf(a),0,0,-260,0,1,0);
-    } else {
-        glLoadIdentity();
-        glRotatef(camera.pitch, 1.0f, 0.0f, 0.0f);
-        glRotatef(camera.yaw, 0.0f, 1.0f, 0.0f);
-        glTranslatef(-camera.x, -camera.y, -camera.z);
-    }
+// Generación de estrellas
+void generateStars(){
+    int m = STAR_COUNT;
+    stars.resize(m);
+    for(int i=0;i<m;i++) stars[i] = initialStar(i, HEAVY_MATH_MODE);
 }
 
 // Dibuja estrellas
 void drawStars(){
-    glDisable(GL_DEPTH_TEST);
-    glBlendFunc(GL_ONE,GL_ONE);
-    glPointSize(1.8f);
-    glBegin(GL_POINTS);
+    TRACE_SCOPE("estrellas");
+    auto stars_start = chrono::high_resolution_clock::now();
     
+    if(headless.enabled){
+        for(auto &s:stars){
+            float tw=0.65f+0.35f*sinf(0.6f*T+s.a*3.f);
+            headless_fb.splat(s.r,s.spd,s.z,0.45f*tw,0.55f*tw,1.0f*tw,1.0f);
+        }
+    }
+#ifndef SCREENSAVER_NO_GL
+    else {
+        glDisable(GL_DEPTH_TEST);
+        glBlendFunc(GL_ONE,GL_ONE);
+        glPointSize(1.8f);
+        glBegin(GL_POINTS);
+        
+        for(auto &s:stars){
+            float tw=0.65f+0.35f*sinf(0.6f*T+s.a*3.f);
+            glColor4f(0.45f*tw,0.55f*tw,1.0f*tw,1.0f);
+            glVertex3f(s.r,s.spd,s.z);
+        }
+        glEnd();
+        glEnable(GL_DEPTH_TEST);
+    }
+#endif
     
-    for(auto &s:stars){
-        float tw=0.65f+0.35f*sinf(0.6f*T+s.a*3.f);
-        glColor4f(0.45f*tw,0.55f*tw,1.0f*tw,1.0f);
-        glVertex3f(s.r,s.spd,s.z);
+    auto stars_end = chrono::high_resolution_clock::now();
+    if (session.timing_enabled) {
+        stars_time += chrono::duration<double>(stars_end - stars_start).count();
     }
-    glEnd();
-    glEnable(GL_DEPTH_TEST);
 }
 
-// Función de color para partículas
-void colorBH(float u,float v,float &r,float &g,float &b){
-    float c1=0.5f+0.5f*sinf(6.2831853f*(u+0.05f*T));
-    float c2=0.5f+0.5f*sinf(6.2831853f*(u*0.5f+0.3f*v)+2.1f+0.1f*T);
-    float c3=0.5f+0.5f*sinf(6.2831853f*(u*0.9f-0.2f*v)+3.6f-0.07f*T);
-    float blue = 0.55f+0.45f*c1;
-    float purple = 0.45f+0.55f*c2;
-    float pink = 0.55f+0.45f*c3;
-    r = 0.25f*blue + 0.35f*purple + 0.80f*pink;
-    g = 0.35f*blue + 0.45f*purple + 0.30f*pink;
-    b = 1.00f*blue + 0.60f*purple + 0.20f*pink;
-}
+// Nombres de los eventos de traza por pase (cadenas estáticas, ver trace.h)
+const char *PASS_TRACE[PASS_COUNT] = {"pase 0", "pase 1", "pase 2", "pase 3", "pase 4", "pase 5"};
 
-// Renderizado de partículas por pasadas
-void pass(float ps,float alphaMul,float znear,float zfar,float swirl,float kdepth){
-    const float INNER_R = 10.0f;
-    glPointSize(ps);
-    glBegin(GL_POINTS);
+// Vértices del pase en curso: el motor los escribe compactos y después se envían en orden
+struct PassVertex { float x, y, z, r, g, b, a; };
+vector<PassVertex> pass_vertices;
+vector<PassCounts> pass_range_counts;
+
+// Renderizado de partículas por pasadas: el kernel escalar del motor (pass_engine.h) instanciado
+// para el pase K sobre el backend secuencial (un tramo: conteo, suma prefija y escritura en el
+// hilo que llama), igual que la versión paralela con un hilo; después se envían los vértices
+template<int K>
+void pass(){
+    TRACE_SCOPE(PASS_TRACE[K]);
+    auto pass_start = chrono::high_resolution_clock::now();
+    
+    const int n = (int)pts.size();
+    auto load = [](int i){ return pts[i]; };
+    auto visible = [](int, float){ return true; };
+    pass_vertices.resize(n);
+    int count[PASS_COUNT] = {0};
+    SequentialBackend backend;
+    computeCompactPasses(backend, n, 1, 0, K, K + 1, pass_range_counts, count,
+        [&](int i0, int i1){ return countPassesScalar<K, K + 1>(i0, i1, T, load, visible); },
+        [&](int i0, int i1, PassCounts pos){
+            PassVertex *out = pass_vertices.data() + pos[K];
+            writePassesScalar<K, K + 1>(i0, i1, T, load, visible,
+                [&](int, float x, float y, float z, float r, float g, float b, float a){ *out++ = {x, y, z, r, g, b, a}; },
+                ExactPalette{T});
+        });
+    
+    if(headless.enabled){
+        for(int i = 0; i < count[K]; i++){
+            const PassVertex &v = pass_vertices[i];
+            headless_fb.splat(v.x,v.y,v.z,v.r,v.g,v.b,v.a);
+        }
+    }
+#ifndef SCREENSAVER_NO_GL
+    else {
+        glPointSize(PASSES[K].ps);
+        glBegin(GL_POINTS);
+        for(int i = 0; i < count[K]; i++){
+            const PassVertex &v = pass_vertices[i];
+            glColor4f(v.r,v.g,v.b,v.a);
+            glVertex3f(v.x,v.y,v.z);
+        }
+        glEnd();
+    }
+#endif
     
-    for(auto &p:pts){
-        float z=p.z+fmodf(T*p.spd,1400.f);
-        if(z>znear||z<zfar) continue;
-        float a=p.a + swirl*T + 0.0019f*z + p.band*(6.2831853f/7.f);
-        float r=p.r*(1.f+0.0011f*z);
-        if(r<INNER_R) r=INNER_R;
-        float wob=0.8f*sinf(0.7f*T+p.band*0.8f+0.02f*z);
-        float x=(r+wob)*cosf(a)+p.jx*sinf(0.9f*T+0.01f*z);
-        float y=(r-wob)*sinf(a)+p.jy*cosf(0.8f*T+0.013f*z);
-        float u=fmodf(0.0025f*z + 0.12f*p.band,1.f);
-        float v=fabsf(z)/1400.f;
-        float cr,cg,cb; colorBH(u,v,cr,cg,cb);
-        float glow=0.6f+0.4f*sinf(2.4f*T+0.3f*p.band+0.003f*z);
-        float centerFade = 0.6f + 0.4f*(r/INNER_R);
-        float fade=(1.f - fminf(1.f,v))*alphaMul*glow*centerFade;
-        glColor4f(cr,cg,cb,fade);
-        glVertex3f(x,y,z);
+    auto pass_end = chrono::high_resolution_clock::now();
+    if (session.timing_enabled) {
+        pass_time[K] += chrono::duration<double>(pass_end - pass_start).count();
     }
-    glEnd();
 }
 
+#ifndef SCREENSAVER_NO_GL
 // Dibuja FPS y texto de ayuda
 void drawFPS() {
-    if (!showFPS) return;
+    drawHud(session, camera, W, H, [](HudText &hud){
+        hud.print("FPS: %.1f | Partículas: %d | Matemática: %dx | Frames: %d | Tiempo: %.2fs | SECUENCIAL",
+                  session.currentFPS, PARTICLE_COUNT, MATH_ITERATIONS, session.frame_count_timing, session.total_computation_time);
+        hud.print("Ops/frame: ~%d | Estrellas: %d | [ESC] Salir y guardar métricas",
+                  PARTICLE_COUNT * MATH_ITERATIONS * 10, STAR_COUNT);
+        hud.line("[C] Modo Camara | [F] Modo FPS | [ y ] Particulas -/+");
+    }, [](HudText &hud){
+        const LatencyStages &l = session.latency_hud;
+        hud.print("p95 ms  Estrellas: %.2f | Pases: %.2f | Swap: %.2f",
+                  l.hist[LAT_STARS].percentileMs(95), l.hist[LAT_PASSES].percentileMs(95), l.hist[LAT_SWAP].percentileMs(95));
+    });
+}
+#endif
+
+// Estrellas y seis pasadas de partículas (común a GLUT y headless)
+void renderScene(){
+    drawStars();
     
-    frameCount++;
-    float currentTime = now();
-    if (currentTime - lastTime >= 1.0f) {
-        currentFPS = frameCount / (currentTime - lastTime);
-        frameCount = 0;
-        lastTime = currentTime;
+    forPasses<0, PASS_COUNT>([](auto k){ pass<decltype(k)::value>(); });
+}
+
+void resizeParticles(int n);
+void draw();
+
+// Política de la versión secuencial para el armazón común (app_shell.h): campo AoS generado en un
+// bucle, escena con el backend secuencial del motor de pases y sin etapas propias en el reporte
+struct SequentialApp {
+    using Initial = vector<Particle>;   // partículas previas a la carga SIMD (solo si se valida)
+    const char *name = "SECUENCIAL";
+    const char *gen_name = "SECUENCIAL";
+    const char *bench_name = "secuencial";
+    
+    // Campo
+    FieldOptions options() const {
+        return {STAR_COUNT, MATH_ITERATIONS, !HEAVY_MATH_MODE ? 0 : FAST_MATH ? 2 : 1, VALIDATE_MATH, PARTICLE_CACHE, CACHE_DIR};
     }
-    
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadIdentity();
-    glOrtho(0, W, 0, H, -1, 1);
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
-    
-    glDisable(GL_DEPTH_TEST);
-    glColor3f(0.0f, 1.0f, 0.0f);
-    
-    char fpsStr[350];
-    sprintf(fpsStr, "FPS: %.1f | Partículas: %d | Matemática: %dx | Frames: %d | Tiempo: %.2fs | SECUENCIAL", 
-            currentFPS, PARTICLE_COUNT, MATH_ITERATIONS, frame_count_timing, total_computation_time);
-    
-    glRasterPos2f(10, H - 25);
-    for (char* c = fpsStr; *c; c++) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, *c);
+    int size() const { return (int)pts.size(); }
+    void create(int n){ pts.resize(n); }
+    void resize(int n){ pts.resize(n); }    // el vector conserva su capacidad al reducir
+    void generate(int i0, int i1, Initial &initial){ generateParticles(i0, i1, initial); }
+    void generateStars(){ ::generateStars(); }
+    void validate(int i0, const Initial &initial){ validateParticles(i0, initial); }
+    vector<Particle> &stars(){ return ::stars; }
+    // Mismo archivo que la versión paralela; aquí las partículas son AoS, así que se copian desde
+    // el mapeo en lugar de usarlo directamente
+    void adopt(ParticleCacheMap &map){
+        const float *a = map.field(0), *z = map.field(1), *r = map.field(2), *spd = map.field(3);
+        const float *band = map.field(4), *jx = map.field(5), *jy = map.field(6);
+        pts.resize(map.header().key.count);
+        for(size_t i = 0; i < pts.size(); i++) pts[i] = {a[i], z[i], r[i], spd[i], band[i], jx[i], jy[i]};
+        particleCacheClose(map);
     }
-    
-    char infoStr[200];
-    sprintf(infoStr, "Ops/frame: ~%d | Estrellas: %d | [ESC] Salir y guardar métricas", 
-            PARTICLE_COUNT * MATH_ITERATIONS * 10, STAR_COUNT);
-    glRasterPos2f(10, H - 45);
-    for (char* c = infoStr; *c; c++) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, *c);
+    float cacheField(int f, size_t i) const {
+        const Particle &p = pts[i];
+        const float values[] = {p.a, p.z, p.r, p.spd, p.band, p.jx, p.jy};
+        return values[f];
     }
-    
-    char controlStr[] = "[C] Modo Camara | [F] Modo FPS";
-    glRasterPos2f(10, H - 65);
-    for (char* c = controlStr; *c; c++) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, *c);
+    void allocate(){}
+    void fieldChanged(){}
+    uint64_t fingerprint() const { return dataFingerprint(); }
+    void reportField(){}
+    void beginResize(){}
+    void resizeNote(ostream &){}
+    void resized(int, int){}
+    
+    // Frame
+    int count() const { return PARTICLE_COUNT; }
+    int step() const { return PARTICLE_STEP; }
+    int threads() const { return 1; }
+    int iterations() const { return MATH_ITERATIONS; }
+    void resizeParticles(int n){ ::resizeParticles(n); }
+    void resetFrameTimers(){ ::resetFrameTimers(); }
+    array<double, 2> stageTotals() const { return ::stageTotals(); }
+    double extraLatency() const { return -1.0; }
+    double headlessFrame(int f){
+        T = f * headless.dt;
+        headless_fb.clear(0.02f,0.02f,0.06f,1.f);
+        headless_fb.setCamera(T);
+        ::renderScene();
+        return 0.0;
     }
-    
-    if (camera.freeMode) {
-        char moveStr[] = "WASD: Movimiento | QE: Arriba/Abajo | Mouse: Mirar";
-        glRasterPos2f(10, H - 85);
-        for (char* c = moveStr; *c; c++) {
-            glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, *c);
+    void reportStages(int frames){
+        printHeadlessStage("Estrellas: cálculo+envío", stars_time, frames);
+        for(int k = 0; k < PASS_COUNT; k++){
+            char stage[64];
+            snprintf(stage, sizeof(stage), "Pase %d: cálculo+envío", k);
+            printHeadlessStage(stage, pass_time[k], frames);
         }
     }
-    
-    glEnable(GL_DEPTH_TEST);
-    glPopMatrix();
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
-    glMatrixMode(GL_MODELVIEW);
+    void reportExtra(){}
+#ifndef SCREENSAVER_NO_GL
+    void beginFrame(int){ T = now(); }
+    void draw(){ ::draw(); }
+    void renderScene(){ ::renderScene(); }
+    void drawHud(){ drawFPS(); }
+    void progress(ostream &){}
+    void quit(){
+        saveTimingMetrics();
+        traceFinish();
+    }
+#endif
+} app;
+
+// Genera partículas y estrellas (cálculo secuencial, o de la caché)
+void gen(int n = -1){
+    generateField(app, session, n == -1 ? PARTICLE_COUNT : n);
 }
 
+// Cambia la cantidad de partículas en caliente (app_shell.h)
+void resizeParticles(int n){
+    resizeField(app, session, PARTICLE_COUNT, n);
+}
+
+#ifndef SCREENSAVER_NO_GL
 // Función principal de dibujo por frame
 void draw(){
-    auto draw_start = chrono::high_resolution_clock::now();
-    
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_ONE,GL_ONE);
-    glDisable(GL_LIGHTING);
-    camera_control();
-    
-    drawStars();
-    
-    
-    pass(1.5f,0.15f,1200.f,-3000.f,0.25f,0.0019f);
-    pass(1.8f,0.25f,900.f,-2600.f,0.35f,0.0019f);
-    pass(2.2f,0.40f,600.f,-2000.f,0.40f,0.0021f);
-    pass(2.6f,0.50f,280.f,-1200.f,0.45f,0.0021f);
-    pass(3.5f,0.75f,150.f,-800.f,0.50f,0.0023f);
-    pass(4.2f,0.95f,80.f,-520.f,0.55f,0.0023f);
-    
-    glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
-    drawFPS();
-    
-    auto draw_end = chrono::high_resolution_clock::now();
-    if (timing_enabled) {
-        total_draw_time += chrono::duration<double>(draw_end - draw_start).count();
-    }
+    drawFrame(app, session, camera, T);
 }
 
 // Callback de display
 void display(){
-    if (timing_enabled) {
-        frame_start = chrono::high_resolution_clock::now();
-    }
-    
-    T=now();
-    glClearColor(0.02f,0.02f,0.06f,1.f);
-    glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
-    glLoadIdentity();
-    draw();
-    glutSwapBuffers();
-    
-    if (timing_enabled) {
-        frame_end = chrono::high_resolution_clock::now();
-        total_computation_time += chrono::duration<double>(frame_end - frame_start).count();
-        frame_count_timing++;
-        
-        
-        if (frame_count_timing % 1000 == 0) {
-            cout << "Frames procesados: " << frame_count_timing << 
-                    ", Tiempo promedio por frame: " << 
-                    (total_computation_time / frame_count_timing) * 1000 << " ms" << 
-                    ", FPS actual: " << currentFPS << endl;
-        }
-    }
+    displayFrame(app, session);
 }
 
-void reshape(int w,int h){ W=w; H=h; proj(); }
+void reshape(int w,int h){ W=w; H=h; cameraProjection(W, H); }
 void idle(){ glutPostRedisplay(); }
+#endif
 
-void key(unsigned char k, int x, int y) {
-    float moveSpeed = camera.speed;
+// Modo headless: simula N frames con T fijo sobre el framebuffer de CPU y reporta tiempos por etapa
+void runHeadless(){
+    headless_fb.resize(W, H);
+    gen();
     
-    switch(k) {
-        case 27: 
-            saveTimingMetrics();
-            exit(0); 
-            break; 
-        case 'c': case 'C': 
-            camera.freeMode = !camera.freeMode;
-            if (!camera.freeMode) {
-                camera.x = 30.0f; camera.y = 5.0f; camera.z = 0.0f;
-                camera.pitch = 0.0f; camera.yaw = 0.0f;
-            }
-            break;
-        case 'w': case 'W':
-            if (camera.freeMode) {
-                camera.x += moveSpeed * sinf(camera.yaw * M_PI/180.0f);
-                camera.z -= moveSpeed * cosf(camera.yaw * M_PI/180.0f);
-            }
-            break;
-        case 's': case 'S':
-            if (camera.freeMode) {
-                camera.x -= moveSpeed * sinf(camera.yaw * M_PI/180.0f);
-                camera.z += moveSpeed * cosf(camera.yaw * M_PI/180.0f);
-            }
-            break;
-        case 'a': case 'A':
-            if (camera.freeMode) {
-                camera.x -= moveSpeed * cosf(camera.yaw * M_PI/180.0f);
-                camera.z -= moveSpeed * sinf(camera.yaw * M_PI/180.0f);
-            }
-            break;
-        case 'd': case 'D':
-            if (camera.freeMode) {
-                camera.x += moveSpeed * cosf(camera.yaw * M_PI/180.0f);
-                camera.z += moveSpeed * sinf(camera.yaw * M_PI/180.0f);
-            }
-            break;
-        case 'q': case 'Q':
-            if (camera.freeMode) camera.y += moveSpeed;
-            break;
-        case 'e': case 'E':
-            if (camera.freeMode) camera.y -= moveSpeed;
-            break;
-        case 'f': case 'F':
-            showFPS = !showFPS;
-            break;
-    }
+    // Latencia de cada frame medido y escalones de la rampa (headless.h)
+    HeadlessFrames frame_times(headless);
+    runHeadlessFrames(app, session, headless, frame_times);
+    reportHeadless(app, session, headless, frame_times, []{
+        double checksum = headless_fb.checksum();
+        cout << "Checksum del framebuffer: " << checksum << endl;
+        return checksum;
+    });
+}
+
+#ifndef SCREENSAVER_NO_GL
+// Teclado: solo las teclas comunes (app_shell.h)
+void key(unsigned char k, int x, int y) {
+    shellKey(app, session, camera, k);
 }
 
+// Mouse y movimiento para mirar en modo cámara libre
 void mouse(int button, int state, int x, int y) {
-    if (button == GLUT_LEFT_BUTTON) {
-        mousePressed = (state == GLUT_DOWN);
-        lastMouseX = x;
-        lastMouseY = y;
-    }
+    if (button == GLUT_LEFT_BUTTON) camera.press(state == GLUT_DOWN, x, y);
 }
 
 void motion(int x, int y) {
-    if (camera.freeMode && mousePressed) {
-        float deltaX = x - lastMouseX;
-        float deltaY = y - lastMouseY;
-        
-        camera.yaw += deltaX * 0.2f;
-        camera.pitch += deltaY * 0.2f;
-        
-        if (camera.pitch > 89.0f) camera.pitch = 89.0f;
-        if (camera.pitch < -89.0f) camera.pitch = -89.0f;
-        
-        lastMouseX = x;
-        lastMouseY = y;
-    }
+    camera.drag(x, y);
 }
 
+#endif
+
+
 int main(int argc,char**argv){
     cout << "SCREENSAVER SECUENCIAL" << endl;
     cout << "====================================================" << endl;
     
+    // Opciones con nombre (--headless, --frames N, --warmup N, --no-save, --trace archivo, --ramp N, ...); el resto son argumentos posicionales
+    vector<char*> args;
+    for(int i = 1; i < argc; i++){
+        string opt = argv[i];
+        if(opt == "--headless") headless.enabled = true;
+        else if(opt == "--frames" && i + 1 < argc) headless.frames = max(1, atoi(argv[++i]));
+        else if(opt == "--warmup" && i + 1 < argc) headless.warmup = max(0, atoi(argv[++i]));
+        else if(opt == "--no-save") headless.save_metrics = false;
+        else if(opt == "--trace" && i + 1 < argc){ trace_enabled = true; trace_path = argv[++i]; }
+        else if(opt == "--libm") FAST_MATH = false;
+        else if(opt == "--validate-math") VALIDATE_MATH = true;
+        else if(opt == "--cache" && i + 1 < argc){ PARTICLE_CACHE = true; CACHE_DIR = argv[++i]; }
+        else if(opt == "--no-cache") PARTICLE_CACHE = false;
+        else if(opt == "--particle-step" && i + 1 < argc) PARTICLE_STEP = max(1, atoi(argv[++i]));
+        else if(opt == "--ramp" && i + 1 < argc) headless.ramp = max(1, atoi(argv[++i]));
+        else args.push_back(argv[i]);
+    }
     
-    if(argc > 1) {
-        PARTICLE_COUNT = atoi(argv[1]);
-        if(PARTICLE_COUNT < 10000) PARTICLE_COUNT = 10000;
-        if(PARTICLE_COUNT > 1000000) PARTICLE_COUNT = 1000000;
+    if(args.size() > 0) {
+        PARTICLE_COUNT = atoi(args[0]);
+        if(PARTICLE_COUNT < PARTICLE_MIN) PARTICLE_COUNT = PARTICLE_MIN;
+        if(PARTICLE_COUNT > PARTICLE_MAX) PARTICLE_COUNT = PARTICLE_MAX;
         cout << "• Partículas configuradas por argumento: " << PARTICLE_COUNT << endl;
     }
     
-    if(argc > 2) {
-        MATH_ITERATIONS = atoi(argv[2]);
+    if(args.size() > 1) {
+        MATH_ITERATIONS = atoi(args[1]);
         if(MATH_ITERATIONS < 1) MATH_ITERATIONS = 1;
         if(MATH_ITERATIONS > 50) MATH_ITERATIONS = 50;
         cout << "• Iteraciones matemáticas configuradas: " << MATH_ITERATIONS << endl;
@@ -471,17 +448,36 @@ int main(int argc,char**argv){
     cout << "   • Estrellas: " << STAR_COUNT << endl;
     cout << "   • Carga computacional estimada: " << (PARTICLE_COUNT * MATH_ITERATIONS * 10) << " ops/frame" << endl;
     cout << "   • Versión: SECUENCIAL" << endl;
-    cout << "   • Passes de renderizado: 6" << endl;
+    cout << "   • Passes de renderizado: " << PASS_COUNT << endl;
+    cout << "   • Carga matemática de gen(): " << (!HEAVY_MATH_MODE ? "desactivada" : FAST_MATH ? "SIMD " SIMD_NAME " (polinomios)" : "libm escalar") << endl;
+    cout << "   • Caché del campo generado: " << (PARTICLE_CACHE ? CACHE_DIR + "/ (mmap)" : string("desactivada")) << endl;
+    cout << "   • Cambio de partículas en caliente: [ / ] de a " << PARTICLE_STEP << endl;
+    if(headless.ramp > 0) cout << "   • Rampa headless: +" << PARTICLE_STEP << " partículas cada " << headless.ramp << " frames" << endl;
+    if(trace_enabled) cout << "   • Traza (Chrome trace-event): " << trace_path << endl;
     cout << endl;
     cout << "Iniciando medición de tiempo..." << endl;
     
-    start_time = chrono::high_resolution_clock::now();
+    session.start_time = chrono::high_resolution_clock::now();
+    
+#ifdef SCREENSAVER_NO_GL
+    headless.enabled = true;
+#endif
+    
+    // Sin ventana: simula los frames pedidos, guarda métricas y termina
+    if(headless.enabled) {
+        cout << "Modo headless: " << headless.frames << " frames sin GLUT" << endl;
+        runHeadless();
+        if(headless.save_metrics) saveTimingMetrics();
+        traceFinish();
+        return 0;
+    }
     
+#ifndef SCREENSAVER_NO_GL
     glutInit(&argc,argv);
     glutInitDisplayMode(GLUT_DOUBLE|GLUT_RGB|GLUT_DEPTH);
     glutInitWindowSize(W,H);
     glutCreateWindow("Agujero de gusano");
-    proj(); 
+    cameraProjection(W, H); 
     gen();
     glEnable(GL_POINT_SMOOTH);
     glutDisplayFunc(display);
@@ -491,5 +487,6 @@ int main(int argc,char**argv){
     glutMouseFunc(mouse);
     glutMotionFunc(motion);
     glutMainLoop();
+#endif
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,326 @@
+// Envoltorio SIMD mínimo: AVX2 (8 floats), SSE2 (4 floats) o escalar (1 float).
+// Los kernels se escriben una sola vez con vfloat/vint y el ancho se decide al compilar.
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SIMD_WIDTH 8
+#define SIMD_NAME "AVX2"
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_WIDTH 4
+#define SIMD_NAME "SSE2"
+#else
+#define SIMD_WIDTH 1
+#define SIMD_NAME "escalar"
+#endif
+
+// Alineación de los arreglos SoA (suficiente para cargas alineadas de AVX)
+#define SIMD_ALIGN 32
+
+// Reserva memoria alineada a SIMD_ALIGN (sin inicializar)
+inline float* simdAllocFloats(size_t count){
+    size_t bytes = ((count * sizeof(float) + SIMD_ALIGN - 1) / SIMD_ALIGN) * SIMD_ALIGN;
+    if(bytes == 0) bytes = SIMD_ALIGN;
+    return (float*)aligned_alloc(SIMD_ALIGN, bytes);
+}
+
+#if SIMD_WIDTH == 8
+
+struct vfloat { __m256 v; vfloat(){} vfloat(__m256 x):v(x){} vfloat(float f):v(_mm256_set1_ps(f)){} };
+struct vint   { __m256i v; vint(){} vint(__m256i x):v(x){} vint(int i):v(_mm256_set1_epi32(i)){} };
+
+inline vfloat vload(const float *p){ return _mm256_load_ps(p); }
+inline void vstore(float *p, vfloat a){ _mm256_store_ps(p, a.v); }
+
+inline vfloat operator+(vfloat a, vfloat b){ return _mm256_add_ps(a.v, b.v); }
+inline vfloat operator-(vfloat a, vfloat b){ return _mm256_sub_ps(a.v, b.v); }
+inline vfloat operator*(vfloat a, vfloat b){ return _mm256_mul_ps(a.v, b.v); }
+inline vfloat operator/(vfloat a, vfloat b){ return _mm256_div_ps(a.v, b.v); }
+inline vfloat operator&(vfloat a, vfloat b){ return _mm256_and_ps(a.v, b.v); }
+inline vfloat operator|(vfloat a, vfloat b){ return _mm256_or_ps(a.v, b.v); }
+inline vfloat operator^(vfloat a, vfloat b){ return _mm256_xor_ps(a.v, b.v); }
+inline vfloat vandnot(vfloat mask, vfloat a){ return _mm256_andnot_ps(mask.v, a.v); }   // ~mask & a
+
+inline vfloat vmin(vfloat a, vfloat b){ return _mm256_min_ps(a.v, b.v); }
+inline vfloat vmax(vfloat a, vfloat b){ return _mm256_max_ps(a.v, b.v); }
+inline vfloat vtrunc(vfloat a){ return _mm256_round_ps(a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+inline vfloat vfloor(vfloat a){ return _mm256_floor_ps(a.v); }
+inline vfloat vsqrt(vfloat a){ return _mm256_sqrt_ps(a.v); }
+
+inline vfloat vlt(vfloat a, vfloat b){ return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+inline vfloat vle(vfloat a, vfloat b){ return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); }
+inline vfloat vgt(vfloat a, vfloat b){ return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+inline vfloat vge(vfloat a, vfloat b){ return _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ); }
+inline vfloat vselect(vfloat mask, vfloat a, vfloat b){ return _mm256_blendv_ps(b.v, a.v, mask.v); }
+inline int vmovemask(vfloat mask){ return _mm256_movemask_ps(mask.v); }
+
+inline vint operator+(vint a, vint b){ return _mm256_add_epi32(a.v, b.v); }
+inline vint operator-(vint a, vint b){ return _mm256_sub_epi32(a.v, b.v); }
+inline vint operator&(vint a, vint b){ return _mm256_and_si256(a.v, b.v); }
+inline vint operator|(vint a, vint b){ return _mm256_or_si256(a.v, b.v); }
+inline vint vandnot(vint mask, vint a){ return _mm256_andnot_si256(mask.v, a.v); }
+template<int S> inline vint vshl(vint a){ return _mm256_slli_epi32(a.v, S); }
+template<int S> inline vint vshr(vint a){ return _mm256_srli_epi32(a.v, S); }   // lógico
+inline vfloat vcmpeq(vint a, vint b){ return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a.v, b.v)); }
+inline vint vcvtt(vfloat a){ return _mm256_cvttps_epi32(a.v); }
+inline vint vcvtr(vfloat a){ return _mm256_cvtps_epi32(a.v); }     // al más cercano (modo por defecto)
+inline void vstore(int32_t *p, vint a){ _mm256_store_si256((__m256i*)p, a.v); }
+inline vfloat vcvt(vint a){ return _mm256_cvtepi32_ps(a.v); }
+inline vint vasint(vfloat a){ return _mm256_castps_si256(a.v); }
+inline vfloat vasfloat(vint a){ return _mm256_castsi256_ps(a.v); }
+inline vfloat vgather(const float *base, vint idx){ return _mm256_i32gather_ps(base, idx.v, 4); }
+
+#elif SIMD_WIDTH == 4
+
+struct vfloat { __m128 v; vfloat(){} vfloat(__m128 x):v(x){} vfloat(float f):v(_mm_set1_ps(f)){} };
+struct vint   { __m128i v; vint(){} vint(__m128i x):v(x){} vint(int i):v(_mm_set1_epi32(i)){} };
+
+inline vfloat vload(const float *p){ return _mm_load_ps(p); }
+inline void vstore(float *p, vfloat a){ _mm_store_ps(p, a.v); }
+
+inline vfloat operator+(vfloat a, vfloat b){ return _mm_add_ps(a.v, b.v); }
+inline vfloat operator-(vfloat a, vfloat b){ return _mm_sub_ps(a.v, b.v); }
+inline vfloat operator*(vfloat a, vfloat b){ return _mm_mul_ps(a.v, b.v); }
+inline vfloat operator/(vfloat a, vfloat b){ return _mm_div_ps(a.v, b.v); }
+inline vfloat operator&(vfloat a, vfloat b){ return _mm_and_ps(a.v, b.v); }
+inline vfloat operator|(vfloat a, vfloat b){ return _mm_or_ps(a.v, b.v); }
+inline vfloat operator^(vfloat a, vfloat b){ return _mm_xor_ps(a.v, b.v); }
+inline vfloat vandnot(vfloat mask, vfloat a){ return _mm_andnot_ps(mask.v, a.v); }
+
+inline vfloat vmin(vfloat a, vfloat b){ return _mm_min_ps(a.v, b.v); }
+inline vfloat vmax(vfloat a, vfloat b){ return _mm_max_ps(a.v, b.v); }
+inline vfloat vsqrt(vfloat a){ return _mm_sqrt_ps(a.v); }
+
+inline vfloat vlt(vfloat a, vfloat b){ return _mm_cmplt_ps(a.v, b.v); }
+inline vfloat vle(vfloat a, vfloat b){ return _mm_cmple_ps(a.v, b.v); }
+inline vfloat vgt(vfloat a, vfloat b){ return _mm_cmpgt_ps(a.v, b.v); }
+inline vfloat vge(vfloat a, vfloat b){ return _mm_cmpge_ps(a.v, b.v); }
+inline vfloat vselect(vfloat mask, vfloat a, vfloat b){ return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+inline int vmovemask(vfloat mask){ return _mm_movemask_ps(mask.v); }
+
+inline vint operator+(vint a, vint b){ return _mm_add_epi32(a.v, b.v); }
+inline vint operator-(vint a, vint b){ return _mm_sub_epi32(a.v, b.v); }
+inline vint operator&(vint a, vint b){ return _mm_and_si128(a.v, b.v); }
+inline vint operator|(vint a, vint b){ return _mm_or_si128(a.v, b.v); }
+inline vint vandnot(vint mask, vint a){ return _mm_andnot_si128(mask.v, a.v); }
+template<int S> inline vint vshl(vint a){ return _mm_slli_epi32(a.v, S); }
+template<int S> inline vint vshr(vint a){ return _mm_srli_epi32(a.v, S); }
+inline vfloat vcmpeq(vint a, vint b){ return _mm_castsi128_ps(_mm_cmpeq_epi32(a.v, b.v)); }
+inline vint vcvtt(vfloat a){ return _mm_cvttps_epi32(a.v); }
+inline vint vcvtr(vfloat a){ return _mm_cvtps_epi32(a.v); }
+inline void vstore(int32_t *p, vint a){ _mm_store_si128((__m128i*)p, a.v); }
+inline vfloat vcvt(vint a){ return _mm_cvtepi32_ps(a.v); }
+inline vint vasint(vfloat a){ return _mm_castps_si128(a.v); }
+inline vfloat vasfloat(vint a){ return _mm_castsi128_ps(a.v); }
+inline vfloat vgather(const float *base, vint idx){
+    alignas(16) int32_t i[4];
+    _mm_store_si128((__m128i*)i, idx.v);
+    return _mm_setr_ps(base[i[0]], base[i[1]], base[i[2]], base[i[3]]);
+}
+
+// SSE2 no tiene redondeo vectorial: se trunca vía int32 (válido para |x| < 2^31, suficiente aquí)
+inline vfloat vtrunc(vfloat a){ return vcvt(vcvtt(a)); }
+inline vfloat vfloor(vfloat a){
+    vfloat t = vtrunc(a);
+    return t - (vgt(t, a) & vfloat(1.0f));
+}
+
+#else
+
+// Respaldo escalar: las máscaras son patrones de bits (todo 1 / todo 0) guardados en un float
+struct vfloat { float v; vfloat(){} vfloat(float f):v(f){} };
+struct vint   { int32_t v; vint(){} vint(int32_t i):v(i){} };
+
+inline vint vasint(vfloat a){ vint r; memcpy(&r.v, &a.v, 4); return r; }
+inline vfloat vasfloat(vint a){ vfloat r; memcpy(&r.v, &a.v, 4); return r; }
+inline vfloat vmaskof(bool b){ return vasfloat(vint(b ? -1 : 0)); }
+
+inline vfloat vload(const float *p){ return *p; }
+inline void vstore(float *p, vfloat a){ *p = a.v; }
+
+inline vfloat operator+(vfloat a, vfloat b){ return a.v + b.v; }
+inline vfloat operator-(vfloat a, vfloat b){ return a.v - b.v; }
+inline vfloat operator*(vfloat a, vfloat b){ return a.v * b.v; }
+inline vfloat operator/(vfloat a, vfloat b){ return a.v / b.v; }
+inline vfloat operator&(vfloat a, vfloat b){ return vasfloat(vasint(a).v & vasint(b).v); }
+inline vfloat operator|(vfloat a, vfloat b){ return vasfloat(vasint(a).v | vasint(b).v); }
+inline vfloat operator^(vfloat a, vfloat b){ return vasfloat(vasint(a).v ^ vasint(b).v); }
+inline vfloat vandnot(vfloat mask, vfloat a){ return vasfloat(~vasint(mask).v & vasint(a).v); }
+
+inline vfloat vmin(vfloat a, vfloat b){ return a.v < b.v ? a.v : b.v; }
+inline vfloat vmax(vfloat a, vfloat b){ return a.v > b.v ? a.v : b.v; }
+inline vfloat vtrunc(vfloat a){ return truncf(a.v); }
+inline vfloat vfloor(vfloat a){ return floorf(a.v); }
+inline vfloat vsqrt(vfloat a){ return sqrtf(a.v); }
+
+inline vfloat vlt(vfloat a, vfloat b){ return vmaskof(a.v < b.v); }
+inline vfloat vle(vfloat a, vfloat b){ return vmaskof(a.v <= b.v); }
+inline vfloat vgt(vfloat a, vfloat b){ return vmaskof(a.v > b.v); }
+inline vfloat vge(vfloat a, vfloat b){ return vmaskof(a.v >= b.v); }
+inline vfloat vselect(vfloat mask, vfloat a, vfloat b){ return vasint(mask).v ? a : b; }
+inline int vmovemask(vfloat mask){ return vasint(mask).v < 0 ? 1 : 0; }
+
+inline vint operator+(vint a, vint b){ return a.v + b.v; }
+inline vint operator-(vint a, vint b){ return a.v - b.v; }
+inline vint operator&(vint a, vint b){ return a.v & b.v; }
+inline vint operator|(vint a, vint b){ return a.v | b.v; }
+inline vint vandnot(vint mask, vint a){ return ~mask.v & a.v; }
+template<int S> inline vint vshl(vint a){ return (int32_t)((uint32_t)a.v << S); }
+template<int S> inline vint vshr(vint a){ return (int32_t)((uint32_t)a.v >> S); }
+inline vfloat vcmpeq(vint a, vint b){ return vmaskof(a.v == b.v); }
+inline vint vcvtt(vfloat a){ return (int32_t)a.v; }
+inline vint vcvtr(vfloat a){ return (int32_t)lrintf(a.v); }
+inline void vstore(int32_t *p, vint a){ *p = a.v; }
+inline vfloat vcvt(vint a){ return (float)a.v; }
+inline vfloat vgather(const float *base, vint idx){ return base[idx.v]; }
+
+#endif
+
+// ---------------------------------------------------------------------------
+// Funciones matemáticas vectoriales (mismo código para todos los anchos)
+// ---------------------------------------------------------------------------
+
+inline vfloat vabs(vfloat a){ return vandnot(vfloat(-0.0f), a); }
+
+// fmodf vectorial: x - trunc(x/y)*y (mismo signo que x, como fmodf)
+inline vfloat vfmod(vfloat x, float y){
+    return x - vtrunc(x * vfloat(1.0f / y)) * vfloat(y);
+}
+
+// sin y cos simultáneos (polinomios de Cephes, reducción de rango Cody-Waite en 3 partes).
+// Error absoluto < 2e-7 para |x| < 8192; fuera de ese rango la precisión se degrada gradualmente.
+inline void vsincos(vfloat x, vfloat &s, vfloat &c){
+    vfloat sign_sin = x & vfloat(-0.0f);
+    x = vabs(x);
+
+    // Octante: j = (int)(x*4/pi), redondeado al par siguiente
+    vint j = vcvtt(x * vfloat(1.27323954473516f));
+    j = (j + vint(1)) & vint(~1);
+    vfloat y = vcvt(j);
+
+    vfloat swap_sin = vasfloat(vshl<29>(j & vint(4)));
+    vfloat poly_mask = vcmpeq(j & vint(2), vint(0));
+    vfloat sign_cos = vasfloat(vshl<29>(vandnot(j - vint(2), vint(4))));
+    sign_sin = sign_sin ^ swap_sin;
+
+    x = ((x - y * vfloat(0.78515625f)) - y * vfloat(2.4187564849853515625e-4f)) - y * vfloat(3.77489497744594108e-8f);
+    vfloat z = x * x;
+
+    vfloat pc = ((vfloat(2.443315711809948e-5f) * z - vfloat(1.388731625493765e-3f)) * z + vfloat(4.166664568298827e-2f)) * z * z
+              - vfloat(0.5f) * z + vfloat(1.0f);
+    vfloat ps = ((vfloat(-1.9515295891e-4f) * z + vfloat(8.3321608736e-3f)) * z - vfloat(1.6666654611e-1f)) * z * x + x;
+
+    s = vselect(poly_mask, ps, pc) ^ sign_sin;
+    c = vselect(poly_mask, pc, ps) ^ sign_cos;
+}
+
+inline vfloat vsin(vfloat x){ vfloat s, c; vsincos(x, s, c); return s; }
+inline vfloat vcos(vfloat x){ vfloat s, c; vsincos(x, s, c); return c; }
+
+// ---------------------------------------------------------------------------
+// Funciones de la carga matemática de gen() (polinomios de Cephes). Cotas de error medidas
+// contra double (2M muestras por rango, AVX2/SSE2/escalar); ver también heavy_math.h.
+//   vexp   x en [-87.3, 88.7]      error relativo < 1.5e-7 (fuera: 0 / inf; NaN se propaga)
+//   vlog   x normal > 0            error relativo < 1.5e-7 (0: -inf, x<0: NaN, inf: inf;
+//                                  los subnormales se tratan como FLT_MIN)
+//   vpow   x > 0                   error relativo < (|y*log x| + 2) * 1.2e-7, es exp(y*log x)
+//   vtan   |x| < 8192              error relativo < 3e-7 + 2e-7/|cos x| (crece cerca de los polos)
+//   vatan  todo x                  error absoluto < 2e-7
+//   vsinh  |x| < 89.4              error relativo < 3e-7 (fuera: ±inf)
+// ---------------------------------------------------------------------------
+
+inline vfloat vallones(){ return vasfloat(vint(-1)); }
+inline vfloat visnan(vfloat x){ return vandnot(vle(x, vfloat(INFINITY)), vallones()); }
+
+inline vfloat vexp(vfloat x){
+    vfloat over = vgt(x, vfloat(88.7228391f)), under = vlt(x, vfloat(-87.3365448f)), nan = visnan(x);
+    vfloat xin = x;
+    x = vmin(vmax(x, vfloat(-87.3365448f)), vfloat(88.7228391f));
+
+    // x = n*ln2 + r, |r| <= ln2/2
+    vfloat fx = vfloor(x * vfloat(1.44269504088896341f) + vfloat(0.5f));
+    x = x - fx * vfloat(0.693359375f) - fx * vfloat(-2.12194440e-4f);
+    vfloat z = x * x;
+    vfloat y = (((((vfloat(1.9875691500e-4f) * x + vfloat(1.3981999507e-3f)) * x + vfloat(8.3334519073e-3f)) * x
+               + vfloat(4.1665795894e-2f)) * x + vfloat(1.6666665459e-1f)) * x + vfloat(5.0000001201e-1f)) * z + x + vfloat(1.0f);
+
+    // 2^n armando el exponente; n = 128 se arma como 2^127 * 2
+    vint n = vcvtt(fx);
+    vfloat big = vgt(fx, vfloat(127.0f));
+    n = n - (vasint(big) & vint(1));
+    y = y * vasfloat(vshl<23>(n + vint(127)));
+    y = vselect(big, y * vfloat(2.0f), y);
+
+    y = vselect(over, vfloat(INFINITY), y);
+    y = vandnot(under, y);
+    return vselect(nan, xin, y);
+}
+
+inline vfloat vlog(vfloat x){
+    vfloat zero = vle(x, vfloat(0.0f)), neg = vlt(x, vfloat(0.0f));
+    vfloat inf = vge(x, vfloat(INFINITY)), nan = visnan(x);
+    vfloat xin = x;
+    x = vmax(x, vfloat(1.17549435e-38f));
+
+    // x = m * 2^e con m en [sqrt(1/2), sqrt(2))
+    vint ix = vasint(x);
+    vint e = vshr<23>(ix) - vint(126);
+    vfloat m = vasfloat((ix & vint(0x007fffff)) | vint(0x3f000000));
+    vfloat small = vlt(m, vfloat(0.707106781186547524f));
+    e = e + vasint(small);                       // la máscara vale -1: e -= 1
+    m = m + (small & m) - vfloat(1.0f);
+    vfloat fe = vcvt(e);
+
+    vfloat z = m * m;
+    vfloat y = ((((((((vfloat(7.0376836292e-2f) * m - vfloat(1.1514610310e-1f)) * m + vfloat(1.1676998740e-1f)) * m
+               - vfloat(1.2420140846e-1f)) * m + vfloat(1.4249322787e-1f)) * m - vfloat(1.6668057665e-1f)) * m
+               + vfloat(2.0000714765e-1f)) * m - vfloat(2.4999993993e-1f)) * m + vfloat(3.3333331174e-1f)) * m * z;
+    y = y + fe * vfloat(-2.12194440e-4f) - vfloat(0.5f) * z;
+    y = m + y + fe * vfloat(0.693359375f);
+
+    y = vselect(zero, vfloat(-INFINITY), y);
+    y = vselect(neg, vfloat(NAN), y);
+    y = vselect(inf, vfloat(INFINITY), y);
+    return vselect(nan, xin, y);
+}
+
+// Potencia para base positiva (el único caso de gen): exp(y*log(x))
+inline vfloat vpow(vfloat x, vfloat y){ return vexp(y * vlog(x)); }
+
+inline vfloat vtan(vfloat x){ vfloat s, c; vsincos(x, s, c); return s / c; }
+
+inline vfloat vatan(vfloat x){
+    vfloat sign = x & vfloat(-0.0f);
+    x = vabs(x);
+
+    // Reducción: x > tan(3pi/8) -> pi/2 + atan(-1/x); x > tan(pi/8) -> pi/4 + atan((x-1)/(x+1))
+    vfloat m1 = vgt(x, vfloat(2.414213562373095f));
+    vfloat m2 = vandnot(m1, vgt(x, vfloat(0.4142135623730950f)));
+    vfloat y0 = (m1 & vfloat(1.5707963267948966f)) | (m2 & vfloat(0.7853981633974483f));
+    x = vselect(m1, vfloat(-1.0f) / x, vselect(m2, (x - vfloat(1.0f)) / (x + vfloat(1.0f)), x));
+
+    vfloat z = x * x;
+    vfloat y = (((vfloat(8.05374449538e-2f) * z - vfloat(1.38776856032e-1f)) * z + vfloat(1.99777106478e-1f)) * z
+               - vfloat(3.33329491539e-1f)) * z * x + x + y0;
+    return y ^ sign;
+}
+
+inline vfloat vsinh(vfloat x){
+    vfloat sign = x & vfloat(-0.0f);
+    vfloat a = vabs(x);
+
+    // |x| <= 1: polinomio; |x| > 1: (e^a - e^-a)/2, y cerca del desborde (e^(a/2))^2 / 2
+    vfloat z = x * x;
+    vfloat small = ((vfloat(2.03721912945e-4f) * z + vfloat(8.33028376239e-3f)) * z + vfloat(1.66667160211e-1f)) * z * x + x;
+    vfloat ea = vexp(a);
+    vfloat large = vfloat(0.5f) * ea - vfloat(0.5f) / ea;
+    vfloat h = vexp(vfloat(0.5f) * a);
+    large = vselect(vgt(a, vfloat(88.0f)), (vfloat(0.5f) * h) * h, large);
+    return vselect(vgt(a, vfloat(1.0f)), large ^ sign, small);
+}
@@ -0,0 +1,87 @@
+// Anillo de buffers del envío por tramos (--stream). Un pase se parte en tramos de partículas: los
+// trabajadores toman los tramos en orden y escriben el tramo c en el buffer c % R, y el hilo que
+// llama (el de GL) los envía en orden apenas están listos. Un tramo solo espera a que se haya
+// enviado el que ocupaba su buffer R tramos antes, así el cálculo de los tramos siguientes se solapa
+// con el envío del actual y la memoria de vértices es de R tramos, no de un buffer por pase del campo.
+#pragma once
+
+#include <omp.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "trace.h"
+
+template<class Buffer>
+class StreamRing {
+public:
+    int slots() const { return (int)ring.size(); }
+    size_t bufferWords() const { return words; }
+
+    // R buffers de `buffer_words` elementos; se conservan mientras no cambie el tamaño
+    void resize(int slots, size_t buffer_words){
+        if(slots == (int)ring.size() && buffer_words == words) return;
+        ring.clear();
+        for(int i = 0; i < slots; i++){
+            ring.push_back(std::make_unique<Slot>());
+            ring.back()->data = Buffer(buffer_words);
+        }
+        words = buffer_words;
+    }
+
+    // Los `chunks` tramos de un pase con `threads` hilos: compute(c, buffer) escribe el tramo c y
+    // devuelve cuántos vértices dejó; submit(c, buffer, count) lo envía, siempre desde el hilo que
+    // llama y en el orden de los tramos. Con un hilo se alternan cálculo y envío en el primer buffer.
+    template<class Compute, class Submit>
+    void run(int chunks, int threads, Compute &&compute, Submit &&submit){
+        if(chunks <= 0 || ring.empty()) return;
+        if(threads <= 1 || ring.size() < 2){
+            for(int c = 0; c < chunks; c++) submit(c, ring[0]->data, compute(c, ring[0]->data));
+            return;
+        }
+        const int R = (int)ring.size();
+        for(auto &s : ring) s->ready.store(-1, std::memory_order_relaxed);
+        std::atomic<int> next{0}, drained{0};
+        auto fill = [&](int c){
+            Slot &s = *ring[c % R];
+            s.count = compute(c, s.data);
+            s.ready.store(c, std::memory_order_release);
+        };
+
+        // El equipo puede ser más chico que `threads` (OMP_DYNAMIC, límites, anidamiento), incluso de
+        // un solo hilo: el que envía también calcula, así que el avance no depende de los trabajadores
+        #pragma omp parallel num_threads(threads)
+        {
+            if(omp_get_thread_num() == 0){
+                TRACE_SCOPE("tramos: envío");
+                for(int c = 0; c < chunks; c++){
+                    Slot &s = *ring[c % R];
+                    // Mientras el tramo c no está listo calcula el siguiente sin tomar, pero solo si su
+                    // buffer ya se envió (p < c + R): este hilo nunca espera por un buffer
+                    while(s.ready.load(std::memory_order_acquire) != c){
+                        int p = next.load(std::memory_order_relaxed);
+                        if(p < chunks && p < c + R && next.compare_exchange_weak(p, p + 1)) fill(p);
+                        else std::this_thread::yield();
+                    }
+                    submit(c, s.data, s.count);
+                    drained.store(c + 1, std::memory_order_release);
+                }
+            } else {
+                TRACE_SCOPE("tramos: cálculo (hilo)");
+                for(int c; (c = next.fetch_add(1)) < chunks; ){
+                    while(drained.load(std::memory_order_acquire) < c - R + 1) std::this_thread::yield();
+                    fill(c);
+                }
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        Buffer data;
+        int count = 0;
+        std::atomic<int> ready{-1};     // tramo cuyo resultado está en el buffer (-1: ninguno)
+    };
+    std::vector<std::unique_ptr<Slot>> ring;
+    size_t words = 0;
+};
@@ -0,0 +1,194 @@
+// Planificador de tareas con robo de trabajo para el frame (--tasks). Cada etapa se parte en
+// tareas con dependencias explícitas en lugar de regiones paralelas con barrera: lo que no
+// depende entre sí (estrellas, conteo de partículas, subidas a GL) se solapa.
+//
+// Cada trabajador tiene su cola: toma del final lo que él mismo liberó (datos aún en caché) y,
+// si se queda sin trabajo, roba del frente de las colas ajenas. Las tareas marcadas main_thread
+// (llamadas GL: el contexto es del hilo principal) van a una cola que solo atiende ese hilo,
+// que además ayuda con el resto mientras espera.
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "trace.h"
+
+// Cola de trabajo con candado (las tareas son gruesas: el candado no se nota)
+struct WorkDeque {
+    std::mutex mutex;
+    std::deque<int> tasks;
+
+    void push(int t){
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(t);
+    }
+    bool pop(int &t){
+        std::lock_guard<std::mutex> lock(mutex);
+        if(tasks.empty()) return false;
+        t = tasks.back();
+        tasks.pop_back();
+        return true;
+    }
+    bool steal(int &t){
+        std::lock_guard<std::mutex> lock(mutex);
+        if(tasks.empty()) return false;
+        t = tasks.front();
+        tasks.pop_front();
+        return true;
+    }
+};
+
+struct TaskNode {
+    const char *name;               // cadena estática (se usa como nombre en la traza)
+    std::function<void()> fn;
+    std::vector<int> successors;
+    int dependencies = 0;
+    bool main_thread = false;
+    std::atomic<int> pending{0};
+};
+
+// Grafo de un frame: se arma, se ejecuta una vez con TaskPool::run y se descarta
+struct TaskGraph {
+    std::vector<std::unique_ptr<TaskNode>> nodes;
+
+    int add(const char *name, std::function<void()> fn, bool main_thread = false){
+        nodes.push_back(std::make_unique<TaskNode>());
+        TaskNode &t = *nodes.back();
+        t.name = name;
+        t.fn = std::move(fn);
+        t.main_thread = main_thread;
+        return (int)nodes.size() - 1;
+    }
+
+    // after no empieza hasta que termine before
+    void depend(int before, int after){
+        nodes[before]->successors.push_back(after);
+        nodes[after]->dependencies++;
+    }
+
+    size_t size() const { return nodes.size(); }
+};
+
+class TaskPool {
+public:
+    ~TaskPool(){ shutdown(); }
+
+    // Hilos totales, contando el principal (que también ejecuta tareas)
+    int threads() const { return (int)queues.size(); }
+
+    void resize(int total_threads){
+        if(total_threads < 1) total_threads = 1;
+        if(total_threads == threads()) return;
+        shutdown();
+        stop = false;
+        for(int i = 0; i < total_threads; i++) queues.push_back(std::make_unique<WorkDeque>());
+        for(int i = 1; i < total_threads; i++) workers.emplace_back(&TaskPool::workerLoop, this, i);
+    }
+
+    // Ejecuta el grafo completo; el hilo que llama (el de GL) corre las tareas main_thread
+    void run(TaskGraph &g){
+        if(g.size() == 0) return;
+        if(queues.empty()) resize(1);
+        for(auto &t : g.nodes) t->pending.store(t->dependencies, std::memory_order_relaxed);
+        remaining.store((int)g.size());
+        int next_queue = 0;
+        for(int i = 0; i < (int)g.size(); i++){
+            if(g.nodes[i]->dependencies == 0) pushReady(g, i, next_queue++ % threads());
+        }
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex);
+            graph = &g;
+            epoch++;
+        }
+        wake.notify_all();
+
+        while(remaining.load() > 0){
+            int t;
+            if(main_only.pop(t) || findWork(0, t)) execute(g, 0, t);
+            else std::this_thread::yield();
+        }
+        // Nadie más entra a este grafo; se espera a que los trabajadores salgan antes de destruirlo
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex);
+            graph = nullptr;
+        }
+        while(active.load() > 0) std::this_thread::yield();
+    }
+
+private:
+    std::vector<std::unique_ptr<WorkDeque>> queues;     // una por hilo; la 0 es la del principal
+    std::vector<std::thread> workers;
+    WorkDeque main_only;
+    std::atomic<int> remaining{0};
+    std::atomic<int> active{0};     // trabajadores dentro del grafo en curso
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    TaskGraph *graph = nullptr;
+    uint64_t epoch = 0;
+    bool stop = false;
+
+    void shutdown(){
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for(std::thread &w : workers) w.join();
+        workers.clear();
+        queues.clear();
+    }
+
+    void pushReady(TaskGraph &g, int t, int queue){
+        if(g.nodes[t]->main_thread) main_only.push(t);
+        else queues[queue]->push(t);
+    }
+
+    // Primero la cola propia (LIFO), luego robar del frente de las demás empezando por la siguiente
+    bool findWork(int id, int &t){
+        if(queues[id]->pop(t)) return true;
+        int n = threads();
+        for(int k = 1; k < n; k++){
+            if(queues[(id + k) % n]->steal(t)) return true;
+        }
+        return false;
+    }
+
+    void execute(TaskGraph &g, int id, int t){
+        TaskNode &node = *g.nodes[t];
+        {
+            TRACE_SCOPE(node.name);
+            node.fn();
+        }
+        for(int s : node.successors){
+            if(g.nodes[s]->pending.fetch_sub(1) == 1) pushReady(g, s, id);
+        }
+        remaining.fetch_sub(1);
+    }
+
+    void workerLoop(int id){
+        uint64_t seen = 0;
+        while(true){
+            TaskGraph *g;
+            {
+                std::unique_lock<std::mutex> lock(wake_mutex);
+                wake.wait(lock, [&]{ return stop || (graph && epoch != seen); });
+                if(stop) return;
+                g = graph;
+                seen = epoch;
+                active++;
+            }
+            while(remaining.load() > 0){
+                int t;
+                if(findWork(id, t)) execute(*g, id, t);
+                else std::this_thread::yield();
+            }
+            active--;
+        }
+    }
+};
@@ -0,0 +1,164 @@
+// Rasterizador de puntos por software (--raster) para máquinas sin GPU, donde Mesa rasteriza el
+// flujo de GL_POINTS en un solo hilo. La pantalla se parte en teselas de TILE x TILE píxeles:
+//
+//   1. Reparto: cada hilo proyecta su tramo de vértices y guarda cada punto en sus propias listas,
+//      una por tesela que el punto toca (sin candados: las listas son del hilo).
+//   2. Teselas: cada tesela la acumula un solo hilo, recorriendo las listas de todos los hilos.
+//   3. Resolución: los acumuladores float se saturan a una imagen RGBA8 que se presenta como textura.
+//
+// La mezcla es aditiva (GL_ONE, GL_ONE), que no depende del orden, así que tampoco hace falta
+// sincronizar entre teselas. Los puntos se suavizan: la cobertura de cada píxel (distancia al
+// centro contra el radio ps/2, con medio píxel de transición) pondera el color completo, no solo el
+// alfa como GL_POINT_SMOOTH, que con GL_ONE dejaría los bordes duros. Sin prueba de profundidad.
+#pragma once
+
+#include <omp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+struct RasterPoint {
+    float x, y, radius;     // centro en píxeles y radio (ps/2)
+    float r, g, b, a;
+};
+
+class TileRasterizer {
+public:
+    static const int TILE = 64;
+
+    int width() const { return w; }
+    int height() const { return h; }
+    const std::vector<uint32_t> &image() const { return rgba8; }
+
+    // Nuevo frame: tamaño de pantalla, proyección*vista (orden de columnas), hilos que van a
+    // repartir y color de fondo. Las listas conservan su capacidad entre frames.
+    void beginFrame(int width, int height, const float *mvp_, int threads, const float clear[4]){
+        if(width != w || height != h){
+            w = width;
+            h = height;
+            tiles_x = (w + TILE - 1) / TILE;
+            tiles_y = (h + TILE - 1) / TILE;
+            accum.assign((size_t)tiles_x * tiles_y * TILE * TILE * 4, 0.f);
+            rgba8.assign((size_t)w * h, 0);
+            bins.clear();
+        }
+        for(int i = 0; i < 16; i++) mvp[i] = mvp_[i];
+        for(int c = 0; c < 4; c++) clear_color[c] = clear[c];
+        if((int)bins.size() < threads) bins.resize(threads);
+        for(auto &thread_bins : bins){
+            thread_bins.resize((size_t)tiles_x * tiles_y);
+            for(auto &list : thread_bins) list.clear();
+        }
+    }
+
+    // Paso 1 para un punto, desde el hilo tid: recorte por el centro en w y en profundidad (como
+    // GL), proyección a píxeles y alta en cada tesela que cubre su disco
+    inline void binPoint(int tid, float x, float y, float z, float r, float g, float b, float a, float size){
+        float cw = mvp[3]*x + mvp[7]*y + mvp[11]*z + mvp[15];
+        if(cw <= 0.0f) return;
+        float cz = mvp[2]*x + mvp[6]*y + mvp[10]*z + mvp[14];
+        if(cz < -cw || cz > cw) return;
+        float inv = 1.0f / cw;
+        float px = ((mvp[0]*x + mvp[4]*y + mvp[8]*z + mvp[12]) * inv * 0.5f + 0.5f) * w;
+        float py = ((mvp[1]*x + mvp[5]*y + mvp[9]*z + mvp[13]) * inv * 0.5f + 0.5f) * h;
+        float radius = 0.5f * size, reach = radius + 0.5f;
+        if(px + reach < 0.f || px - reach >= w || py + reach < 0.f || py - reach >= h) return;
+
+        int tx0 = std::max(0, (int)((px - reach) / TILE)), tx1 = std::min(tiles_x - 1, (int)((px + reach) / TILE));
+        int ty0 = std::max(0, (int)((py - reach) / TILE)), ty1 = std::min(tiles_y - 1, (int)((py + reach) / TILE));
+        auto &thread_bins = bins[tid];
+        for(int ty = ty0; ty <= ty1; ty++){
+            for(int tx = tx0; tx <= tx1; tx++){
+                thread_bins[(size_t)ty * tiles_x + tx].push_back({px, py, radius, r, g, b, a});
+            }
+        }
+    }
+
+    // Pasos 2 y 3: acumula cada tesela y la resuelve a RGBA8
+    void rasterize(int threads){
+        const int tiles = tiles_x * tiles_y;
+        #pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
+        for(int t = 0; t < tiles; t++) rasterizeTile(t);
+    }
+
+    // Suma del color saturado a [0,1] (misma medida que HeadlessFramebuffer::checksum)
+    double checksum() const {
+        double sum = 0.0;
+        for(int t = 0; t < tiles_x * tiles_y; t++){
+            int x0, y0, tw, th;
+            tileRect(t, x0, y0, tw, th);
+            const float *acc = &accum[(size_t)t * TILE * TILE * 4];
+            for(int y = 0; y < th; y++){
+                for(int x = 0; x < tw; x++){
+                    const float *p = acc + (y * TILE + x) * 4;
+                    sum += std::min(p[0], 1.f) + std::min(p[1], 1.f) + std::min(p[2], 1.f);
+                }
+            }
+        }
+        return sum;
+    }
+
+    // Puntos repartidos en el último frame (un punto cuenta una vez por tesela que toca)
+    size_t binnedPoints() const {
+        size_t n = 0;
+        for(const auto &thread_bins : bins) for(const auto &list : thread_bins) n += list.size();
+        return n;
+    }
+
+private:
+    int w = 0, h = 0, tiles_x = 0, tiles_y = 0;
+    float mvp[16];
+    float clear_color[4] = {0.f, 0.f, 0.f, 0.f};
+    std::vector<std::vector<std::vector<RasterPoint>>> bins;    // [hilo][tesela]
+    std::vector<float> accum;       // RGBA float, TILE*TILE píxeles contiguos por tesela
+    std::vector<uint32_t> rgba8;    // imagen resuelta, filas de abajo hacia arriba (como GL)
+
+    void tileRect(int t, int &x0, int &y0, int &tw, int &th) const {
+        x0 = (t % tiles_x) * TILE;
+        y0 = (t / tiles_x) * TILE;
+        tw = std::min(TILE, w - x0);
+        th = std::min(TILE, h - y0);
+    }
+
+    static inline uint32_t toByte(float v){
+        return (uint32_t)(std::min(1.f, std::max(0.f, v)) * 255.f + 0.5f);
+    }
+
+    void rasterizeTile(int t){
+        int x0, y0, tw, th;
+        tileRect(t, x0, y0, tw, th);
+        float *acc = &accum[(size_t)t * TILE * TILE * 4];
+        for(int i = 0; i < TILE * TILE; i++){
+            for(int c = 0; c < 4; c++) acc[i*4 + c] = clear_color[c];
+        }
+
+        for(const auto &thread_bins : bins){
+            for(const RasterPoint &p : thread_bins[t]){
+                float reach = p.radius + 0.5f, reach2 = reach * reach;
+                int ix0 = std::max(x0, (int)(p.x - reach)), ix1 = std::min(x0 + tw - 1, (int)(p.x + reach));
+                int iy0 = std::max(y0, (int)(p.y - reach)), iy1 = std::min(y0 + th - 1, (int)(p.y + reach));
+                for(int iy = iy0; iy <= iy1; iy++){
+                    float dy = iy + 0.5f - p.y;
+                    float *row = acc + (iy - y0) * TILE * 4;
+                    for(int ix = ix0; ix <= ix1; ix++){
+                        float dx = ix + 0.5f - p.x, d2 = dx*dx + dy*dy;
+                        if(d2 >= reach2) continue;
+                        float cover = std::min(1.f, reach - sqrtf(d2));
+                        float *dst = row + (ix - x0) * 4;
+                        dst[0] += p.r * cover; dst[1] += p.g * cover; dst[2] += p.b * cover; dst[3] += p.a * cover;
+                    }
+                }
+            }
+        }
+
+        for(int y = 0; y < th; y++){
+            uint32_t *out = &rgba8[(size_t)(y0 + y) * w + x0];
+            const float *src = acc + y * TILE * 4;
+            for(int x = 0; x < tw; x++){
+                const float *p = src + x * 4;
+                out[x] = toByte(p[0]) | toByte(p[1]) << 8 | toByte(p[2]) << 16 | toByte(p[3]) << 24;
+            }
+        }
+    }
+};
@@ -0,0 +1,127 @@
+// Instrumentación por etapas: temporizadores con alcance (TRACE_SCOPE) que guardan eventos en
+// un buffer circular por hilo y se exportan en formato Chrome trace-event (Perfetto, chrome://tracing).
+// Activación en tiempo de ejecución con --trace archivo.json; desactivada, cada TRACE_SCOPE
+// cuesta una lectura de trace_enabled. Con SCREENSAVER_NO_TRACE los TRACE_SCOPE desaparecen.
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Un intervalo [start, start + dur) en ns desde el inicio del programa.
+// name debe ser una cadena estática: solo se guarda el puntero.
+struct TraceEvent {
+    const char *name;
+    int64_t start_ns;
+    int64_t dur_ns;
+};
+
+// Buffer circular de un hilo: al llenarse se sobrescriben los eventos más viejos
+struct TraceRing {
+    int tid = 0;
+    std::vector<TraceEvent> events;
+    uint64_t written = 0;
+
+    void push(const TraceEvent &e){
+        events[written % events.size()] = e;
+        written++;
+    }
+};
+
+inline bool trace_enabled = false;          // --trace
+inline std::string trace_path;              // archivo de salida
+inline size_t trace_ring_capacity = 1 << 16;   // eventos por hilo
+
+// Registro global de buffers; cada hilo registra el suyo la primera vez que graba
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<TraceRing>> rings;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+};
+
+inline TraceRegistry &traceRegistry(){
+    static TraceRegistry registry;
+    return registry;
+}
+
+inline int64_t traceNow(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - traceRegistry().t0).count();
+}
+
+inline TraceRing *traceThreadRing(){
+    thread_local TraceRing *ring = nullptr;
+    if(!ring){
+        TraceRegistry &reg = traceRegistry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.rings.push_back(std::make_unique<TraceRing>());
+        ring = reg.rings.back().get();
+        ring->tid = (int)reg.rings.size() - 1;
+        ring->events.resize(trace_ring_capacity);
+    }
+    return ring;
+}
+
+// Temporizador con alcance: graba un evento al destruirse si la traza está activa
+struct TraceScope {
+    const char *name;
+    int64_t start = 0;
+
+    explicit TraceScope(const char *n) : name(trace_enabled ? n : nullptr){
+        if(name) start = traceNow();
+    }
+    ~TraceScope(){
+        if(name) traceThreadRing()->push({name, start, traceNow() - start});
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope &operator=(const TraceScope&) = delete;
+};
+
+#ifndef SCREENSAVER_NO_TRACE
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#endif
+
+// Escribe los eventos de todos los hilos como JSON de Chrome trace-event ("ph":"X", tiempos en µs).
+// Se llama con los hilos de trabajo detenidos (al salir).
+inline bool traceWriteChrome(const std::string &path){
+    FILE *f = fopen(path.c_str(), "w");
+    if(!f) return false;
+    TraceRegistry &reg = traceRegistry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    uint64_t dropped = 0;
+    for(const auto &ring : reg.rings){
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"hilo %d\"}}",
+                first ? "" : ",\n", ring->tid, ring->tid);
+        first = false;
+        size_t cap = ring->events.size();
+        uint64_t begin = ring->written > cap ? ring->written - cap : 0;
+        dropped += begin;
+        for(uint64_t i = begin; i < ring->written; i++){
+            const TraceEvent &e = ring->events[i % cap];
+            fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    e.name, ring->tid, e.start_ns / 1000.0, e.dur_ns / 1000.0);
+        }
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    printf("Traza escrita en %s (%zu hilos%s)\n", path.c_str(), reg.rings.size(),
+           dropped ? ", se descartaron eventos antiguos" : "");
+    return true;
+}
+
+// Exporta la traza si se pidió con --trace
+inline void traceFinish(){
+    if(trace_enabled && !traceWriteChrome(trace_path)){
+        fprintf(stderr, "No se pudo escribir la traza en %s\n", trace_path.c_str());
+    }
+}
@@ -0,0 +1,215 @@
+// Índice de visibilidad analítico de las partículas (--index; solo en los pases sin fusionar). La
+// profundidad de una partícula en el instante T es z0 + fmod(T*spd, 1400): un diente de sierra en
+// forma cerrada. Al generar, las partículas se agrupan en cubetas por velocidad y profundidad inicial
+// y se copian a un SoA propio ordenadas por cubeta, cada cubeta desde el comienzo de un bloque SIMD.
+// Con las cotas de velocidad y de z0 de una cubeta se acota dónde puede estar en T, así que por frame
+// y pase se enumeran solo las cubetas que pueden caer en el rango del pase (y en rebanadas que el
+// recorte no descarta); el resto se salta en bloque, sin leer sus partículas. Los kernels siguen
+// probando cada partícula: el índice solo descarta, nunca decide que algo se ve.
+//
+// Los pases 0-3 abarcan todo el recorrido de z (z0 + [0, 1400)), así que solo los pases 4 y 5 saltan
+// cubetas y los 6 fusionados no saltan ninguna: sin fusionar se recorre ~84% de los bloques.
+// La dispersión de una cubeta crece con T (T por el ancho de su rango de velocidades): a T grandes
+// cada cubeta abarca más profundidades y se descarta menos, pero el resultado es el mismo.
+#pragma once
+
+#include <omp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include "simd.h"
+#include "numa.h"
+
+// Arreglos SoA que leen los kernels de pases (los de la caché y pts: a, z, r, spd, band, jx, jy)
+struct ParticleArrays {
+    const float *a, *z, *r, *spd, *band, *jx, *jy;
+};
+
+// Tramos de bloques SIMD [b0,b1) a recorrer en un frame, con la cantidad de bloques activos antes
+// de cada uno para repartir las unidades de trabajo en rangos
+struct ActiveSpans {
+    struct Span { int b0, b1, start; };
+    std::vector<Span> spans;
+    int blocks = 0;
+
+    void clear(){
+        spans.clear();
+        blocks = 0;
+    }
+
+    void add(int b0, int b1){
+        if(b0 >= b1) return;
+        if(!spans.empty() && spans.back().b1 == b0) spans.back().b1 = b1;
+        else spans.push_back({b0, b1, blocks});
+        blocks += b1 - b0;
+    }
+
+    // Llama fn(u0, u1) con los tramos contiguos de unidades reales que corresponden a las unidades
+    // activas [a0, a1), con `scale` unidades por bloque (1 en el kernel SIMD, SIMD_WIDTH en el escalar)
+    template<class F>
+    void forUnits(int a0, int a1, int scale, F &&fn) const {
+        if(a0 >= a1) return;
+        auto it = std::upper_bound(spans.begin(), spans.end(), a0 / scale,
+                                   [](int b, const Span &s){ return b < s.start; });
+        for(size_t s = (size_t)(it - spans.begin()) - 1; s < spans.size() && a0 < a1; s++){
+            const Span &sp = spans[s];
+            int active_end = (sp.start + sp.b1 - sp.b0) * scale;
+            int take = std::min(a1, active_end) - a0;
+            int u0 = sp.b0 * scale + (a0 - sp.start * scale);
+            fn(u0, u0 + take);
+            a0 += take;
+        }
+    }
+};
+
+class VisibilityIndex {
+public:
+    static const int DEPTH_BINS = 32;       // rebanadas de z0 de ~37 unidades: el borde de un pase estrecho corta pocas cubetas
+    static const int BUCKET_TARGET = 64;    // partículas por cubeta buscadas (el relleno es < SIMD_WIDTH por cubeta)
+
+    struct Bucket {
+        float spd_min, spd_max, z0_min, z0_max;
+        int b0, b1;                          // bloques SIMD de la cubeta en el SoA del índice
+    };
+
+    ~VisibilityIndex(){ release(); }
+
+    bool built() const { return n > 0; }
+    size_t size() const { return n; }
+    int blocks() const { return (int)(capacity / SIMD_WIDTH); }
+    int speedBins() const { return speed_bins; }
+    size_t bucketCount() const { return buckets.size(); }
+    ParticleArrays arrays() const { return {field[0], field[1], field[2], field[3], field[4], field[5], field[6]}; }
+
+    // Ordena por cubeta las `count` partículas de src (orden estable: dentro de una cubeta se
+    // conserva el orden original, así el resultado no depende de la cantidad de hilos)
+    void build(const ParticleArrays &src, size_t count, int threads){
+        release();
+        if(count == 0) return;
+        const float *in[FIELDS] = {src.a, src.z, src.r, src.spd, src.band, src.jx, src.jy};
+        const int N = (int)count;
+
+        // Rangos de velocidad y profundidad inicial del campo
+        float spd_lo = in[3][0], spd_hi = in[3][0], z_lo = in[1][0], z_hi = in[1][0];
+        #pragma omp parallel for num_threads(threads) reduction(min:spd_lo, z_lo) reduction(max:spd_hi, z_hi)
+        for(int i = 0; i < N; i++){
+            spd_lo = std::min(spd_lo, in[3][i]); spd_hi = std::max(spd_hi, in[3][i]);
+            z_lo = std::min(z_lo, in[1][i]); z_hi = std::max(z_hi, in[1][i]);
+        }
+        speed_bins = std::max(1, N / (BUCKET_TARGET * DEPTH_BINS));
+        const int B = speed_bins * DEPTH_BINS;
+        const float spd_scale = speed_bins / std::max(spd_hi - spd_lo, 1e-6f);
+        const float z_scale = DEPTH_BINS / std::max(z_hi - z_lo, 1e-6f);
+        auto key = [&](int i){
+            int s = std::min(speed_bins - 1, (int)((in[3][i] - spd_lo) * spd_scale));
+            int d = std::min(DEPTH_BINS - 1, (int)((in[1][i] - z_lo) * z_scale));
+            return s * DEPTH_BINS + d;
+        };
+
+        // Conteo por tramo y cubeta sobre la partición estática en `threads` tramos; la posición de
+        // cada tramo en cada cubeta es la suma de las cubetas anteriores (rellenas a SIMD_WIDTH) y de
+        // los tramos anteriores
+        std::vector<std::vector<int>> pos(threads, std::vector<int>(B, 0));
+        #pragma omp parallel for num_threads(threads) schedule(static, 1)
+        for(int t = 0; t < threads; t++){
+            size_t i0, i1;
+            staticRange(count, t, threads, i0, i1);
+            for(size_t i = i0; i < i1; i++) pos[t][key((int)i)]++;
+        }
+        buckets.resize(B);
+        std::vector<int> fill(B);
+        int offset = 0;
+        for(int b = 0; b < B; b++){
+            int start = offset;
+            for(int t = 0; t < threads; t++){
+                int c = pos[t][b];
+                pos[t][b] = offset;
+                offset += c;
+            }
+            fill[b] = offset;
+            offset = (offset + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+            buckets[b] = {0.f, 0.f, 0.f, 0.f, start / SIMD_WIDTH, offset / SIMD_WIDTH};
+        }
+        capacity = std::max((size_t)offset, (size_t)SIMD_WIDTH);
+        n = count;
+
+        // Reserva con primer toque paralelo, relleno fuera de cualquier rango visible y reparto
+        for(int f = 0; f < FIELDS; f++){
+            field[f] = simdAllocFloats(capacity);
+            firstTouchFloats(field[f], nullptr, 0, capacity, SIMD_WIDTH, threads);
+        }
+        for(int b = 0; b < B; b++){
+            for(int i = fill[b]; i < buckets[b].b1 * SIMD_WIDTH; i++) field[1][i] = 1.0e9f;
+        }
+        #pragma omp parallel for num_threads(threads) schedule(static, 1)
+        for(int t = 0; t < threads; t++){
+            size_t i0, i1;
+            staticRange(count, t, threads, i0, i1);
+            for(size_t i = i0; i < i1; i++){
+                int dst = pos[t][key((int)i)]++;
+                for(int f = 0; f < FIELDS; f++) field[f][dst] = in[f][i];
+            }
+        }
+
+        // Cotas reales de cada cubeta (más ajustadas que los bordes de la grilla)
+        #pragma omp parallel for num_threads(threads) schedule(dynamic, 64)
+        for(int b = 0; b < B; b++){
+            Bucket &bk = buckets[b];
+            int first = bk.b0 * SIMD_WIDTH, last = fill[b];
+            if(first == last) continue;
+            bk.spd_min = bk.spd_max = field[3][first];
+            bk.z0_min = bk.z0_max = field[1][first];
+            for(int i = first + 1; i < last; i++){
+                bk.spd_min = std::min(bk.spd_min, field[3][i]); bk.spd_max = std::max(bk.spd_max, field[3][i]);
+                bk.z0_min = std::min(bk.z0_min, field[1][i]); bk.z0_max = std::max(bk.z0_max, field[1][i]);
+            }
+        }
+        // Las cubetas vacías (sin bloques) no se recorren nunca
+        buckets.erase(std::remove_if(buckets.begin(), buckets.end(), [](const Bucket &bk){ return bk.b0 == bk.b1; }),
+                      buckets.end());
+    }
+
+    // Cubetas que en el instante T pueden tener partículas con profundidad en [zmin, zmax] y donde
+    // depth_visible(lo, hi) admite algo del intervalo [lo, hi] (el recorte por rebanadas)
+    template<class DepthVisible>
+    void activeSpans(float T, float zmin, float zmax, DepthVisible &&depth_visible, ActiveSpans &out) const {
+        const double PERIOD = 1400.0;
+        auto hit = [&](double lo, double hi){
+            lo = std::max(lo, (double)zmin);
+            hi = std::min(hi, (double)zmax);
+            return lo <= hi && depth_visible((float)lo, (float)hi);
+        };
+        for(const Bucket &bk : buckets){
+            // Desplazamiento fmod(T*spd, 1400) de la cubeta, con margen para el redondeo en float del kernel
+            double margin = 1.0 + 1e-6 * T * bk.spd_max;
+            double o_lo = (double)T * bk.spd_min - margin, o_hi = (double)T * bk.spd_max + margin;
+            bool visible;
+            if(o_hi - o_lo >= PERIOD) visible = hit(bk.z0_min, bk.z0_max + PERIOD);
+            else {
+                double base = o_lo - floor(o_lo / PERIOD) * PERIOD, top = base + (o_hi - o_lo);
+                visible = hit(bk.z0_min + base, bk.z0_max + std::min(top, PERIOD)) ||
+                          (top > PERIOD && hit(bk.z0_min, bk.z0_max + (top - PERIOD)));
+            }
+            if(visible) out.add(bk.b0, bk.b1);
+        }
+    }
+
+    void release(){
+        for(float *&f : field){
+            free(f);
+            f = nullptr;
+        }
+        buckets.clear();
+        n = capacity = 0;
+        speed_bins = 0;
+    }
+
+private:
+    static const int FIELDS = 7;
+    float *field[FIELDS] = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+    size_t n = 0, capacity = 0;
+    int speed_bins = 0;
+    std::vector<Bucket> buckets;
+};